@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PixelStreamingRenderOnDemand.h"
+#include "PrimitiveSceneProxy.h"
+#include "Framework/Application/IInputProcessor.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Misc/DelayedAutoRegister.h"
+
+namespace UE::PixelStreaming
+{
+	/** Sees player input as Pixel Streaming injects it into Slate. */
+	class FRenderOnDemandHooks::FInputProcessor : public IInputProcessor
+	{
+	public:
+		virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override {}
+
+		virtual bool HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override { return Invalidate(); }
+		virtual bool HandleKeyUpEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override { return Invalidate(); }
+		virtual bool HandleAnalogInputEvent(FSlateApplication& SlateApp, const FAnalogInputEvent& InAnalogInputEvent) override { return Invalidate(); }
+		virtual bool HandleMouseMoveEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override { return Invalidate(); }
+		virtual bool HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override { return Invalidate(); }
+		virtual bool HandleMouseButtonUpEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override { return Invalidate(); }
+		virtual bool HandleMouseWheelOrGestureEvent(FSlateApplication& SlateApp, const FPointerEvent& InWheelEvent, const FPointerEvent* InGestureEvent) override { return Invalidate(); }
+
+		virtual const TCHAR* GetDebugName() const override { return TEXT("PixelStreamingRenderOnDemand"); }
+
+	private:
+		bool Invalidate()
+		{
+			FPrimitiveSceneProxy::NotifySceneChanged();
+			return false;
+		}
+	};
+
+	FRenderOnDemandHooks& FRenderOnDemandHooks::Get()
+	{
+		static FRenderOnDemandHooks Instance;
+		return Instance;
+	}
+
+	void FRenderOnDemandHooks::Initialize()
+	{
+		check(IsInGameThread());
+		if (bInitialized || !FSlateApplication::IsInitialized())
+		{
+			return;
+		}
+
+		FSlateApplication::Get().RegisterInputPreProcessor(MakeShared<FInputProcessor>());
+		bInitialized = true;
+	}
+
+	// 模块加载晚于引擎初始化时立即执行
+	static FDelayedAutoRegisterHelper GRenderOnDemandHooksRegistration(EDelayedRegisterRunPhase::EndOfEngineInit, []() {
+		FRenderOnDemandHooks::Get().Initialize();
+	});
+} // namespace UE::PixelStreaming
@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace UE::PixelStreaming
+{
+	/**
+	 * Keeps r.RenderOnDemand in step with the stream: injected player input invalidates the last frame even when Slate does
+	 * not count it as user interaction. Viewer count changes reach render on demand through the tick rate governor (see
+	 * FTickRateGovernorHooks). Initializes itself at the end of engine init, so it works for every streamer whatever video
+	 * input it uses.
+	 */
+	class FRenderOnDemandHooks
+	{
+	public:
+		static FRenderOnDemandHooks& Get();
+
+		/** Game thread only, safe to call more than once. Does nothing without Slate (e.g. -nullrhi). */
+		void Initialize();
+
+	private:
+		class FInputProcessor;
+
+		bool bInitialized = false;
+	};
+} // namespace UE::PixelStreaming
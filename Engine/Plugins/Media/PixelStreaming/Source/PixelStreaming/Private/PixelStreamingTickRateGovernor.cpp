@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PixelStreamingTickRateGovernor.h"
+#include "PixelStreamingDelegates.h"
+#include "PixelStreamingStatNames.h"
+#include "TickRateGovernor.h"
+#include "Utils.h"
+#include "Misc/DelayedAutoRegister.h"
+
+namespace UE::PixelStreaming
+{
+	FTickRateGovernorHooks& FTickRateGovernorHooks::Get()
+	{
+		static FTickRateGovernorHooks Instance;
+		return Instance;
+	}
+
+	void FTickRateGovernorHooks::Initialize()
+	{
+		check(IsInGameThread());
+		if (bInitialized)
+		{
+			return;
+		}
+
+		if (UPixelStreamingDelegates* Delegates = UPixelStreamingDelegates::GetPixelStreamingDelegates())
+		{
+			Delegates->OnNewConnectionNative.AddRaw(this, &FTickRateGovernorHooks::OnNewConnection);
+			Delegates->OnClosedConnectionNative.AddRaw(this, &FTickRateGovernorHooks::OnClosedConnection);
+			Delegates->OnAllConnectionsClosedNative.AddRaw(this, &FTickRateGovernorHooks::OnAllConnectionsClosed);
+			Delegates->OnStatChangedNative.AddRaw(this, &FTickRateGovernorHooks::OnStatChanged);
+		}
+		bInitialized = true;
+	}
+
+	void FTickRateGovernorHooks::OnNewConnection(FString StreamerId, FString PlayerId, bool bIsQualityController)
+	{
+		// 连接事件可能来自信令线程
+		DoOnGameThread([this, StreamerId, PlayerId]() {
+			Players.FindOrAdd(StreamerId).Add(PlayerId);
+			PublishViewerCount();
+		});
+	}
+
+	void FTickRateGovernorHooks::OnClosedConnection(FString StreamerId, FString PlayerId, bool bWasQualityController)
+	{
+		DoOnGameThread([this, StreamerId, PlayerId]() {
+			if (TSet<FString>* StreamerPlayers = Players.Find(StreamerId))
+			{
+				StreamerPlayers->Remove(PlayerId);
+			}
+			PlayerFrameRates.Remove(PlayerId);
+			PublishViewerCount();
+			PublishBackPressure();
+		});
+	}
+
+	void FTickRateGovernorHooks::OnAllConnectionsClosed(FString StreamerId)
+	{
+		DoOnGameThread([this, StreamerId]() {
+			if (const TSet<FString>* StreamerPlayers = Players.Find(StreamerId))
+			{
+				for (const FString& PlayerId : *StreamerPlayers)
+				{
+					PlayerFrameRates.Remove(PlayerId);
+				}
+			}
+			Players.Remove(StreamerId);
+			PublishViewerCount();
+			PublishBackPressure();
+		});
+	}
+
+	void FTickRateGovernorHooks::OnStatChanged(FString PlayerId, FName StatName, float StatValue)
+	{
+		if (StatName != PixelStreamingStatNames::SourceFps && StatName != PixelStreamingStatNames::FramesSentPerSecond)
+		{
+			return;
+		}
+
+		// 统计在WebRTC线程上报
+		DoOnGameThread([this, PlayerId, StatName, StatValue]() {
+			FPlayerFrameRates& FrameRates = PlayerFrameRates.FindOrAdd(PlayerId);
+			if (StatName == PixelStreamingStatNames::SourceFps)
+			{
+				FrameRates.SourceFps = StatValue;
+			}
+			else
+			{
+				FrameRates.FramesSentPerSecond = StatValue;
+			}
+			PublishBackPressure();
+		});
+	}
+
+	void FTickRateGovernorHooks::PublishViewerCount() const
+	{
+		int32 ViewerCount = 0;
+		for (const TPair<FString, TSet<FString>>& Pair : Players)
+		{
+			ViewerCount += Pair.Value.Num();
+		}
+
+		// 按需渲染在观众数变化时重绘，并在有观众时保持最低重绘频率
+		FTickRateGovernor::Get().SetViewerCount(ViewerCount);
+	}
+
+	void FTickRateGovernorHooks::PublishBackPressure() const
+	{
+		// 编码器或发送队列跟不上时，送进去的帧有一部分没发出去；按最差的玩家降低帧率
+		float BackPressure = 0.0f;
+		for (const TPair<FString, FPlayerFrameRates>& Pair : PlayerFrameRates)
+		{
+			if (Pair.Value.SourceFps > 0.0f)
+			{
+				BackPressure = FMath::Max(BackPressure, 1.0f - Pair.Value.FramesSentPerSecond / Pair.Value.SourceFps);
+			}
+		}
+		FTickRateGovernor::Get().SetBackPressure(BackPressure);
+	}
+
+	// 模块加载晚于引擎初始化时立即执行
+	static FDelayedAutoRegisterHelper GTickRateGovernorHooksRegistration(EDelayedRegisterRunPhase::EndOfEngineInit, []() {
+		FTickRateGovernorHooks::Get().Initialize();
+	});
+} // namespace UE::PixelStreaming
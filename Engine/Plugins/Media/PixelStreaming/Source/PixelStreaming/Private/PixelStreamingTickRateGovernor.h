@@ -0,0 +1,42 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace UE::PixelStreaming
+{
+	/**
+	 * Feeds the engine's tick rate governor from the stream. Connected players are its viewer count, and the share of captured
+	 * frames the encoders did not send (SourceFps against FramesSentPerSecond, worst player) is its back-pressure, so the engine
+	 * stops rendering frames the stream drops anyway. Initializes itself at the end of engine init.
+	 */
+	class FTickRateGovernorHooks
+	{
+	public:
+		static FTickRateGovernorHooks& Get();
+
+		/** Game thread only, safe to call more than once. */
+		void Initialize();
+
+	private:
+		void OnNewConnection(FString StreamerId, FString PlayerId, bool bIsQualityController);
+		void OnClosedConnection(FString StreamerId, FString PlayerId, bool bWasQualityController);
+		void OnAllConnectionsClosed(FString StreamerId);
+		void OnStatChanged(FString PlayerId, FName StatName, float StatValue);
+		void PublishViewerCount() const;
+		void PublishBackPressure() const;
+
+		struct FPlayerFrameRates
+		{
+			float SourceFps = 0.0f;
+			float FramesSentPerSecond = 0.0f;
+		};
+
+		bool bInitialized = false;
+
+		// Game thread.
+		TMap<FString, TSet<FString>> Players;
+		TMap<FString, FPlayerFrameRates> PlayerFrameRates;
+	};
+} // namespace UE::PixelStreaming
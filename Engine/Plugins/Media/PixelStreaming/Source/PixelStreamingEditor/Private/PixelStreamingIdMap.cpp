@@ -0,0 +1,215 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PixelStreamingIdMap.h"
+#include "DasIdMap.h"
+#include "IPixelStreamingStreamer.h"
+#include "PixelStreamingDelegates.h"
+#include "PixelStreamingInputProtocol.h"
+#include "Utils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Base64.h"
+#include "Misc/Compression.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIGPUReadback.h"
+#include "SceneRenderTargetParameters.h"
+#include "UnrealClient.h"
+
+namespace UE::PixelStreaming
+{
+	static TAutoConsoleVariable<bool> CVarPixelStreamingIdMap(
+		TEXT("PixelStreaming.IdMap"),
+		false,
+		TEXT("If true, a downscaled DasStencil ID map is sent to players as DasIdMap Response messages so the browser can resolve hover IDs without a round trip."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<int32> CVarPixelStreamingIdMapCellSize(
+		TEXT("PixelStreaming.IdMap.CellSize"),
+		8,
+		TEXT("Frame pixels per ID map cell in each direction."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarPixelStreamingIdMapInterval(
+		TEXT("PixelStreaming.IdMap.Interval"),
+		0.1f,
+		TEXT("Minimum seconds between two ID maps."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarPixelStreamingIdMapKeyFrameInterval(
+		TEXT("PixelStreaming.IdMap.KeyFrameInterval"),
+		2.0f,
+		TEXT("Seconds between two key ID maps, which carry the IDs instead of the difference to the previous map."),
+		ECVF_Default);
+
+	FIdMapStreamer& FIdMapStreamer::Get()
+	{
+		static FIdMapStreamer IdMapStreamer;
+		return IdMapStreamer;
+	}
+
+	bool FIdMapStreamer::IsEnabled()
+	{
+		return CVarPixelStreamingIdMap.GetValueOnAnyThread();
+	}
+
+	void FIdMapStreamer::Initialize()
+	{
+		check(IsInGameThread());
+		if (bInitialized)
+		{
+			return;
+		}
+
+		if (UPixelStreamingDelegates* Delegates = UPixelStreamingDelegates::GetPixelStreamingDelegates())
+		{
+			Delegates->OnNewConnectionNative.AddRaw(this, &FIdMapStreamer::OnNewConnection);
+		}
+		bInitialized = true;
+	}
+
+	void FIdMapStreamer::OnNewConnection(FString StreamerId, FString PlayerId, bool bIsQualityController)
+	{
+		// 新玩家没有上一张图，下一张给这个streamer发关键图
+		ENQUEUE_RENDER_COMMAND(RequestDasIdKeyMap)
+		([this, StreamerId](FRHICommandList& RHICmdList) {
+			if (FStreamerState* State = StreamerStates.Find(StreamerId))
+			{
+				State->bKeyMapRequested = true;
+			}
+		});
+	}
+
+	void FIdMapStreamer::SendMap(const TWeakPtr<IPixelStreamingStreamer>& Streamer, TArray<uint32> Payload, FIntPoint Extent, bool bKeyMap, uint32 MapSequence)
+	{
+		// 同一个管道里按顺序压缩和发送，客户端按seq异或不会错位
+		SendPipe.Launch(TEXT("PixelStreamingIdMapSend"), [Streamer, Payload = MoveTemp(Payload), Extent, bKeyMap, MapSequence]() {
+			const int32 UncompressedSize = Payload.Num() * sizeof(uint32);
+			int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, UncompressedSize);
+			TArray<uint8> Compressed;
+			Compressed.SetNumUninitialized(CompressedSize);
+			if (!FCompression::CompressMemory(NAME_Zlib, Compressed.GetData(), CompressedSize, Payload.GetData(), UncompressedSize))
+			{
+				return;
+			}
+			Compressed.SetNum(CompressedSize);
+
+			const FString Descriptor = FString::Printf(TEXT("{\"type\":\"DasIdMap\",\"seq\":%u,\"key\":%s,\"width\":%d,\"height\":%d,\"data\":\"%s\"}"),
+				MapSequence,
+				bKeyMap ? TEXT("true") : TEXT("false"),
+				Extent.X,
+				Extent.Y,
+				*FBase64::Encode(Compressed));
+
+			// 游戏线程的任务按入队顺序执行
+			DoOnGameThread([Streamer, Descriptor]() {
+				if (TSharedPtr<IPixelStreamingStreamer> PinnedStreamer = Streamer.Pin())
+				{
+					const uint8 ResponseId = FPixelStreamingInputProtocol::FromStreamerProtocol.Find("Response")->GetID();
+					PinnedStreamer->SendPlayerMessage(ResponseId, Descriptor);
+				}
+			});
+		});
+	}
+
+	void FIdMapStreamer::ProcessReadbacks(FViewportState& ViewportState)
+	{
+		TArray<FPendingMap>& PendingReadbacks = ViewportState.PendingReadbacks;
+		while (PendingReadbacks.Num() > 0 && PendingReadbacks[0].Readback->IsReady())
+		{
+			FPendingMap Pending = MoveTemp(PendingReadbacks[0]);
+			PendingReadbacks.RemoveAt(0);
+
+			const int32 NumCells = Pending.Extent.X * Pending.Extent.Y;
+			const uint32* Ids = static_cast<const uint32*>(Pending.Readback->Lock(NumCells * sizeof(uint32)));
+			const TArray<uint32> CurrentIds(Ids, NumCells);
+			Pending.Readback->Unlock();
+
+			const double Now = FPlatformTime::Seconds();
+			for (const TWeakPtr<IPixelStreamingStreamer>& WeakStreamer : Pending.Streamers)
+			{
+				TSharedPtr<IPixelStreamingStreamer> Streamer = WeakStreamer.Pin();
+				if (!Streamer)
+				{
+					continue;
+				}
+
+				// 每个streamer的玩家收到的上一张图不同，各自做异或，不变的格子为0，压缩后几乎没有体积
+				FStreamerState& State = StreamerStates.FindOrAdd(Streamer->GetId());
+				const bool bKeyMap = State.bKeyMapRequested
+					|| Pending.Extent != State.PreviousExtent
+					|| Now - State.LastKeyMapTime >= CVarPixelStreamingIdMapKeyFrameInterval.GetValueOnRenderThread();
+				TArray<uint32> Payload = CurrentIds;
+				bool bChanged = bKeyMap;
+				if (!bKeyMap)
+				{
+					for (int32 Index = 0; Index < NumCells; ++Index)
+					{
+						Payload[Index] ^= State.PreviousIds[Index];
+						bChanged |= Payload[Index] != 0;
+					}
+				}
+
+				State.PreviousIds = CurrentIds;
+				State.PreviousExtent = Pending.Extent;
+				if (!bChanged)
+				{
+					continue;
+				}
+
+				if (bKeyMap)
+				{
+					State.LastKeyMapTime = Now;
+					State.bKeyMapRequested = false;
+				}
+
+				SendMap(WeakStreamer, MoveTemp(Payload), Pending.Extent, bKeyMap, State.Sequence++);
+			}
+		}
+	}
+
+	void FIdMapStreamer::Update(FRHICommandListImmediate& RHICmdList, const FViewport* Viewport, FIntPoint FrameExtent, const TArray<TWeakPtr<IPixelStreamingStreamer>>& Streamers)
+	{
+		FViewportState& ViewportState = ViewportStates.FindOrAdd(Viewport);
+		ProcessReadbacks(ViewportState);
+
+		const double Now = FPlatformTime::Seconds();
+		if (Now - ViewportState.LastMapTime < CVarPixelStreamingIdMapInterval.GetValueOnRenderThread() || ViewportState.PendingReadbacks.Num() >= MaxPendingReadbacks || Streamers.Num() == 0)
+		{
+			return;
+		}
+
+		// 移动端按需渲染自定义深度，保证下一张ID图有数据
+		RequestDasCustomDepthFrame();
+
+		// 只用这个视口自己那次场景渲染的DasStencil，别的视口或场景捕获的图对不上
+		const FDasTextureExtracts* DasExtracts = GetDasTextureExtracts(Viewport);
+		FRHITexture* DasStencil = DasExtracts ? DasExtracts->GetDasStencil() : nullptr;
+		if (DasStencil == nullptr || FrameExtent.X <= 0 || FrameExtent.Y <= 0)
+		{
+			return;
+		}
+		ViewportState.LastMapTime = Now;
+
+		const FIntPoint Extent = FIntPoint::DivideAndRoundUp(FrameExtent, FMath::Max(CVarPixelStreamingIdMapCellSize.GetValueOnRenderThread(), 1));
+
+		FRDGBuilder GraphBuilder(RHICmdList);
+
+		FRDGTextureRef DasStencilTexture = GraphBuilder.RegisterExternalTexture(DasExtracts->DasStencil, TEXT("PixelStreamingDasStencil"));
+		const FIntRect MaskRect(DasExtracts->ViewRect.Min, DasExtracts->ViewRect.Max.ComponentMin(DasStencilTexture->Desc.Extent));
+		FRDGBufferRef Ids = AddDasIdMapPass(GraphBuilder, DasStencilTexture, MaskRect, Extent);
+
+		FPendingMap& Pending = ViewportState.PendingReadbacks.AddDefaulted_GetRef();
+		Pending.Readback = MakeUnique<FRHIGPUBufferReadback>(TEXT("PixelStreamingIdMap"));
+		Pending.Extent = Extent;
+		Pending.Streamers = Streamers;
+		AddEnqueueCopyPass(GraphBuilder, Pending.Readback.Get(), Ids, 0u);
+
+		GraphBuilder.Execute();
+	}
+
+	void FIdMapStreamer::RemoveViewport(const FViewport* Viewport)
+	{
+		check(IsInRenderingThread());
+		ViewportStates.Remove(Viewport);
+	}
+} // namespace UE::PixelStreaming
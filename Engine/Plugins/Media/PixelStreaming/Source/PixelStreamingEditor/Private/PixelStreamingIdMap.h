@@ -0,0 +1,84 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Pipe.h"
+
+class FRHICommandListImmediate;
+class FRHIGPUBufferReadback;
+class FViewport;
+class IPixelStreamingStreamer;
+
+namespace UE::PixelStreaming
+{
+	/**
+	 * Periodically sends a downscaled DasStencil ID map to the browser as a Response message, so the page resolves hover IDs
+	 * locally and only asks the streamer for an exact pick on click. Message JSON:
+	 *
+	 *   { "type": "DasIdMap", "seq": 12, "key": false, "width": 240, "height": 135, "data": "<base64>" }
+	 *
+	 * data is a zlib stream (DecompressionStream("deflate") in the browser) of width * height little endian uint32 IDs, row by
+	 * row over the whole frame. Key maps hold the IDs themselves, other maps hold the XOR with the previous map, and a map that
+	 * did not change is not sent. Every streamer has its own previous map and sequence. A key map is sent when a player joins
+	 * and every PixelStreaming.IdMap.KeyFrameInterval seconds for players that lost a message. Maps are compressed on a
+	 * pipe, so they reach the players in sequence order. Each streamed viewport has its own interval and readbacks, and its
+	 * map is taken from the DasStencil of that viewport's own scene render.
+	 */
+	class FIdMapStreamer
+	{
+	public:
+		static FIdMapStreamer& Get();
+		static bool IsEnabled();
+
+		/** Hooks player connections to send a key map to new players. Game thread only, safe to call more than once. */
+		void Initialize();
+
+		/** Computes the ID map of a frame of the viewport sent to the given streamers if one is due and sends finished maps. Render thread. */
+		void Update(FRHICommandListImmediate& RHICmdList, const FViewport* Viewport, FIntPoint FrameExtent, const TArray<TWeakPtr<IPixelStreamingStreamer>>& Streamers);
+
+		/** Drops the state of a viewport that is no longer streamed. Render thread, after its last Update. */
+		void RemoveViewport(const FViewport* Viewport);
+
+	private:
+		struct FViewportState;
+
+		void ProcessReadbacks(FViewportState& ViewportState);
+		void SendMap(const TWeakPtr<IPixelStreamingStreamer>& Streamer, TArray<uint32> Payload, FIntPoint Extent, bool bKeyMap, uint32 MapSequence);
+		void OnNewConnection(FString StreamerId, FString PlayerId, bool bIsQualityController);
+
+		struct FPendingMap
+		{
+			TUniquePtr<FRHIGPUBufferReadback> Readback;
+			FIntPoint Extent = FIntPoint::ZeroValue;
+			TArray<TWeakPtr<IPixelStreamingStreamer>> Streamers;
+		};
+
+		/** What the players of one streamer last received. */
+		struct FStreamerState
+		{
+			TArray<uint32> PreviousIds;
+			FIntPoint PreviousExtent = FIntPoint::ZeroValue;
+			double LastKeyMapTime = 0.0;
+			uint32 Sequence = 0;
+			bool bKeyMapRequested = false;
+		};
+
+		struct FViewportState
+		{
+			TArray<FPendingMap> PendingReadbacks;
+			double LastMapTime = 0.0;
+		};
+
+		static constexpr int32 MaxPendingReadbacks = 4;
+
+		bool bInitialized = false;
+
+		// Render thread.
+		TMap<const FViewport*, FViewportState> ViewportStates;
+		TMap<FString, FStreamerState> StreamerStates;
+
+		// Compresses and sends maps one after another.
+		UE::Tasks::FPipe SendPipe{ TEXT("PixelStreamingIdMap") };
+	};
+} // namespace UE::PixelStreaming
@@ -0,0 +1,283 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PixelStreamingLatencyTracker.h"
+#include "Framework/Application/IInputProcessor.h"
+#include "Framework/Application/SlateApplication.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("PixelStreaming Latency"), STATGROUP_PixelStreamingLatency, STATCAT_Advanced);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input To Frame Start p50 (ms)"), STAT_PixelStreaming_InputToFrameStartP50, STATGROUP_PixelStreamingLatency);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input To Frame Start p95 (ms)"), STAT_PixelStreaming_InputToFrameStartP95, STATGROUP_PixelStreamingLatency);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Frame Start To Render Submit p50 (ms)"), STAT_PixelStreaming_FrameStartToRenderSubmitP50, STATGROUP_PixelStreamingLatency);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Frame Start To Render Submit p95 (ms)"), STAT_PixelStreaming_FrameStartToRenderSubmitP95, STATGROUP_PixelStreamingLatency);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Render Submit To Capture p50 (ms)"), STAT_PixelStreaming_RenderSubmitToCaptureP50, STATGROUP_PixelStreamingLatency);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Render Submit To Capture p95 (ms)"), STAT_PixelStreaming_RenderSubmitToCaptureP95, STATGROUP_PixelStreamingLatency);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input To Capture p50 (ms)"), STAT_PixelStreaming_InputToCaptureP50, STATGROUP_PixelStreamingLatency);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input To Capture p95 (ms)"), STAT_PixelStreaming_InputToCaptureP95, STATGROUP_PixelStreamingLatency);
+
+CSV_DEFINE_CATEGORY(PixelStreamingLatency, true);
+
+namespace UE::PixelStreaming
+{
+	static TAutoConsoleVariable<bool> CVarPixelStreamingLatencyEnable(
+		TEXT("PixelStreaming.Latency.Enable"),
+		false,
+		TEXT("If true, input arrival, frame start, render submit and capture of streamed frames are timestamped. See PixelStreaming.Latency.Dump."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarPixelStreamingLatencyStatWindow(
+		TEXT("PixelStreaming.Latency.StatWindow"),
+		1.0f,
+		TEXT("Seconds of samples the published p50/p95 latency stats are computed over."),
+		ECVF_Default);
+
+	static FAutoConsoleCommand CmdPixelStreamingLatencyDump(
+		TEXT("PixelStreaming.Latency.Dump"),
+		TEXT("Prints p50/p95/p99 of each latency stage from input arrival to frame capture over the last samples."),
+		FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar) { FLatencyTracker::Get().DumpPercentiles(Ar); }));
+
+	static FAutoConsoleCommand CmdPixelStreamingLatencyReset(
+		TEXT("PixelStreaming.Latency.Reset"),
+		TEXT("Discards the collected latency samples."),
+		FConsoleCommandDelegate::CreateLambda([]() { FLatencyTracker::Get().Reset(); }));
+
+	/** Stamps input as Slate receives it, before any widget or the game sees it. */
+	class FLatencyTracker::FInputProcessor : public IInputProcessor
+	{
+	public:
+		virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override {}
+
+		virtual bool HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override { return Stamp(); }
+		virtual bool HandleKeyUpEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override { return Stamp(); }
+		virtual bool HandleAnalogInputEvent(FSlateApplication& SlateApp, const FAnalogInputEvent& InAnalogInputEvent) override { return Stamp(); }
+		virtual bool HandleMouseMoveEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override { return Stamp(); }
+		virtual bool HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override { return Stamp(); }
+		virtual bool HandleMouseButtonUpEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override { return Stamp(); }
+		virtual bool HandleMouseWheelOrGestureEvent(FSlateApplication& SlateApp, const FPointerEvent& InWheelEvent, const FPointerEvent* InGestureEvent) override { return Stamp(); }
+
+		virtual const TCHAR* GetDebugName() const override { return TEXT("PixelStreamingLatency"); }
+
+	private:
+		bool Stamp()
+		{
+			FLatencyTracker::Get().OnInput();
+			return false;
+		}
+	};
+
+	void FLatencyTracker::FStageSamples::Add(float Value)
+	{
+		if (Milliseconds.Num() < MaxSamples)
+		{
+			Milliseconds.Add(Value);
+		}
+		else
+		{
+			Milliseconds[NextIndex] = Value;
+		}
+		NextIndex = (NextIndex + 1) % MaxSamples;
+
+		if (WindowMilliseconds.Num() < MaxSamples)
+		{
+			WindowMilliseconds.Add(Value);
+		}
+	}
+
+	float FLatencyTracker::FStageSamples::GetPercentile(float Percentile) const
+	{
+		if (Milliseconds.Num() == 0)
+		{
+			return 0.0f;
+		}
+
+		TArray<float> Sorted = Milliseconds;
+		Sorted.Sort();
+		const int32 Index = FMath::Clamp(FMath::CeilToInt32(Percentile * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+		return Sorted[Index];
+	}
+
+	void FLatencyTracker::FStageSamples::CompleteWindow()
+	{
+		// 窗口内没有样本时保留上一个窗口的值
+		if (WindowMilliseconds.Num() > 0)
+		{
+			WindowMilliseconds.Sort();
+			const auto WindowPercentile = [this](float Percentile)
+			{
+				return WindowMilliseconds[FMath::Clamp(FMath::CeilToInt32(Percentile * WindowMilliseconds.Num()) - 1, 0, WindowMilliseconds.Num() - 1)];
+			};
+			WindowP50 = WindowPercentile(0.5f);
+			WindowP95 = WindowPercentile(0.95f);
+			WindowMilliseconds.Reset();
+		}
+	}
+
+	FLatencyTracker& FLatencyTracker::Get()
+	{
+		static FLatencyTracker Tracker;
+		return Tracker;
+	}
+
+	bool FLatencyTracker::IsEnabled()
+	{
+		return CVarPixelStreamingLatencyEnable.GetValueOnAnyThread();
+	}
+
+	void FLatencyTracker::Initialize()
+	{
+		check(IsInGameThread());
+		if (bInitialized || !FSlateApplication::IsInitialized())
+		{
+			return;
+		}
+
+		FSlateApplication::Get().RegisterInputPreProcessor(MakeShared<FInputProcessor>());
+		FCoreDelegates::OnBeginFrame.AddRaw(this, &FLatencyTracker::OnBeginFrame);
+		bInitialized = true;
+	}
+
+	void FLatencyTracker::OnInput()
+	{
+		// Slate processes input after the world ticked and the viewport was drawn, so the next frame is the first that can show it.
+		// 每帧只记录最早的输入，衡量的是用户最久等待的那次操作
+		const uint64 InputFrameId = CurrentFrameId + 1;
+		if (IsEnabled() && (PendingInputs.Num() == 0 || PendingInputs.Last().FrameId != InputFrameId) && PendingInputs.Num() < MaxPendingInputs)
+		{
+			PendingInputs.Add({ InputFrameId, FPlatformTime::Seconds() });
+		}
+	}
+
+	void FLatencyTracker::OnBeginFrame()
+	{
+		if (!IsEnabled())
+		{
+			PendingInputs.Reset();
+			return;
+		}
+
+		// 上一帧已经推流的话，它显示了之前的所有输入
+		if (SubmittedFrameId == CurrentFrameId)
+		{
+			PendingInputs.RemoveAll([this](const FPendingInput& Input) { return Input.FrameId <= CurrentFrameId; });
+		}
+
+		CurrentFrameId = GFrameCounter;
+		FrameStartTime = FPlatformTime::Seconds();
+	}
+
+	FFrameLatencyStamps FLatencyTracker::StampRenderSubmit()
+	{
+		FFrameLatencyStamps Stamps;
+		if (IsEnabled())
+		{
+			Stamps.FrameId = CurrentFrameId;
+			Stamps.FrameStartTime = FrameStartTime;
+			Stamps.RenderSubmitTime = FPlatformTime::Seconds();
+
+			if (PendingInputs.Num() > 0 && PendingInputs[0].FrameId <= CurrentFrameId)
+			{
+				Stamps.InputTime = PendingInputs[0].Time;
+			}
+			SubmittedFrameId = CurrentFrameId;
+		}
+		return Stamps;
+	}
+
+	void FLatencyTracker::RecordCapture(FFrameLatencyStamps Stamps)
+	{
+		if (Stamps.RenderSubmitTime == 0.0)
+		{
+			return;
+		}
+
+		Stamps.CaptureTime = FPlatformTime::Seconds();
+
+		const float FrameStartToRenderSubmitMs = float((Stamps.RenderSubmitTime - Stamps.FrameStartTime) * 1000.0);
+		const float RenderSubmitToCaptureMs = float((Stamps.CaptureTime - Stamps.RenderSubmitTime) * 1000.0);
+
+		FScopeLock Lock(&SamplesCS);
+		Samples[FrameStartToRenderSubmit].Add(FrameStartToRenderSubmitMs);
+		Samples[RenderSubmitToCapture].Add(RenderSubmitToCaptureMs);
+
+		if (Stamps.InputTime > 0.0 && Stamps.FrameId != LastInputSampleFrameId)
+		{
+			LastInputSampleFrameId = Stamps.FrameId;
+			Samples[InputToFrameStart].Add(float((Stamps.FrameStartTime - Stamps.InputTime) * 1000.0));
+			Samples[InputToCapture].Add(float((Stamps.CaptureTime - Stamps.InputTime) * 1000.0));
+		}
+
+		if (Stamps.CaptureTime - WindowStartTime >= FMath::Max(CVarPixelStreamingLatencyStatWindow.GetValueOnRenderThread(), 0.0f))
+		{
+			for (FStageSamples& StageSamples : Samples)
+			{
+				StageSamples.CompleteWindow();
+			}
+			WindowStartTime = Stamps.CaptureTime;
+		}
+		PublishStats();
+	}
+
+	void FLatencyTracker::PublishStats()
+	{
+		const float InputToFrameStartP50Ms = Samples[InputToFrameStart].WindowP50;
+		const float InputToFrameStartP95Ms = Samples[InputToFrameStart].WindowP95;
+		const float FrameStartToRenderSubmitP50Ms = Samples[FrameStartToRenderSubmit].WindowP50;
+		const float FrameStartToRenderSubmitP95Ms = Samples[FrameStartToRenderSubmit].WindowP95;
+		const float RenderSubmitToCaptureP50Ms = Samples[RenderSubmitToCapture].WindowP50;
+		const float RenderSubmitToCaptureP95Ms = Samples[RenderSubmitToCapture].WindowP95;
+		const float InputToCaptureP50Ms = Samples[InputToCapture].WindowP50;
+		const float InputToCaptureP95Ms = Samples[InputToCapture].WindowP95;
+
+		SET_FLOAT_STAT(STAT_PixelStreaming_InputToFrameStartP50, InputToFrameStartP50Ms);
+		SET_FLOAT_STAT(STAT_PixelStreaming_InputToFrameStartP95, InputToFrameStartP95Ms);
+		SET_FLOAT_STAT(STAT_PixelStreaming_FrameStartToRenderSubmitP50, FrameStartToRenderSubmitP50Ms);
+		SET_FLOAT_STAT(STAT_PixelStreaming_FrameStartToRenderSubmitP95, FrameStartToRenderSubmitP95Ms);
+		SET_FLOAT_STAT(STAT_PixelStreaming_RenderSubmitToCaptureP50, RenderSubmitToCaptureP50Ms);
+		SET_FLOAT_STAT(STAT_PixelStreaming_RenderSubmitToCaptureP95, RenderSubmitToCaptureP95Ms);
+		SET_FLOAT_STAT(STAT_PixelStreaming_InputToCaptureP50, InputToCaptureP50Ms);
+		SET_FLOAT_STAT(STAT_PixelStreaming_InputToCaptureP95, InputToCaptureP95Ms);
+
+		CSV_CUSTOM_STAT(PixelStreamingLatency, InputToFrameStartP50Ms, InputToFrameStartP50Ms, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(PixelStreamingLatency, InputToFrameStartP95Ms, InputToFrameStartP95Ms, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(PixelStreamingLatency, FrameStartToRenderSubmitP50Ms, FrameStartToRenderSubmitP50Ms, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(PixelStreamingLatency, FrameStartToRenderSubmitP95Ms, FrameStartToRenderSubmitP95Ms, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(PixelStreamingLatency, RenderSubmitToCaptureP50Ms, RenderSubmitToCaptureP50Ms, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(PixelStreamingLatency, RenderSubmitToCaptureP95Ms, RenderSubmitToCaptureP95Ms, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(PixelStreamingLatency, InputToCaptureP50Ms, InputToCaptureP50Ms, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(PixelStreamingLatency, InputToCaptureP95Ms, InputToCaptureP95Ms, ECsvCustomStatOp::Set);
+	}
+
+	void FLatencyTracker::DumpPercentiles(FOutputDevice& Ar) const
+	{
+		static const TCHAR* StageNames[NumStages] = {
+			TEXT("Input -> frame start"),
+			TEXT("Frame start -> render submit"),
+			TEXT("Render submit -> capture"),
+			TEXT("Input -> capture"),
+		};
+
+		FScopeLock Lock(&SamplesCS);
+		for (int32 Stage = 0; Stage < NumStages; ++Stage)
+		{
+			const FStageSamples& StageSamples = Samples[Stage];
+			Ar.Logf(TEXT("PixelStreaming latency %-30s samples %4d  p50 %7.2fms  p95 %7.2fms  p99 %7.2fms"),
+				StageNames[Stage],
+				StageSamples.Milliseconds.Num(),
+				StageSamples.GetPercentile(0.5f),
+				StageSamples.GetPercentile(0.95f),
+				StageSamples.GetPercentile(0.99f));
+		}
+	}
+
+	void FLatencyTracker::Reset()
+	{
+		FScopeLock Lock(&SamplesCS);
+		for (FStageSamples& StageSamples : Samples)
+		{
+			StageSamples = FStageSamples();
+		}
+	}
+} // namespace UE::PixelStreaming
@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace UE::PixelStreaming
+{
+	/** FPlatformTime::Seconds() of each stage one frame passed through. Zero means the stage was not reached. */
+	struct FFrameLatencyStamps
+	{
+		/** GFrameCounter at the start of the frame, input is matched to the first frame that could show it. */
+		uint64 FrameId = 0;
+		double InputTime = 0.0;
+		double FrameStartTime = 0.0;
+		double RenderSubmitTime = 0.0;
+		double CaptureTime = 0.0;
+	};
+
+	/**
+	 * Measures latency from input arrival to the frame being handed to the capturer, broken down per stage.
+	 * Input is tagged with the first frame that can react to it and stays pending until a streamed frame with that or a later
+	 * id is submitted, so frames that are not streamed do not lose it. p50/p95 over PixelStreaming.Latency.StatWindow are
+	 * published as stats and CSV stats, PixelStreaming.Latency.Dump prints percentiles over the last samples.
+	 */
+	class FLatencyTracker
+	{
+	public:
+		static FLatencyTracker& Get();
+
+		/** Hooks input arrival and frame start. Game thread only, safe to call more than once. */
+		void Initialize();
+
+		/** Returns the stamps of the frame whose viewport was just rendered, with the earliest input it shows. Game thread only. */
+		FFrameLatencyStamps StampRenderSubmit();
+
+		/** Completes a frame when it is handed to the capturer. Render thread. */
+		void RecordCapture(FFrameLatencyStamps Stamps);
+
+		void DumpPercentiles(FOutputDevice& Ar) const;
+		void Reset();
+
+		static bool IsEnabled();
+
+	private:
+		void OnInput();
+		void OnBeginFrame();
+
+		enum EStage
+		{
+			InputToFrameStart,
+			FrameStartToRenderSubmit,
+			RenderSubmitToCapture,
+			InputToCapture,
+			NumStages
+		};
+
+		static constexpr int32 MaxSamples = 1024;
+
+		struct FStageSamples
+		{
+			TArray<float> Milliseconds;
+			int32 NextIndex = 0;
+
+			/** Samples of the current stat window and the percentiles of the last completed one. */
+			TArray<float> WindowMilliseconds;
+			float WindowP50 = 0.0f;
+			float WindowP95 = 0.0f;
+
+			void Add(float Value);
+			float GetPercentile(float Percentile) const;
+			void CompleteWindow();
+		};
+
+		struct FPendingInput
+		{
+			uint64 FrameId = 0;
+			double Time = 0.0;
+		};
+
+		static constexpr int32 MaxPendingInputs = 64;
+
+		void PublishStats();
+
+		class FInputProcessor;
+		friend class FInputProcessor;
+
+		bool bInitialized = false;
+
+		// Game thread. Earliest input per frame id, oldest first.
+		TArray<FPendingInput> PendingInputs;
+		uint64 CurrentFrameId = 0;
+		uint64 SubmittedFrameId = 0;
+		double FrameStartTime = 0.0;
+
+		// Render thread. Several viewports or streamers may capture the same frame, its input is only counted once.
+		uint64 LastInputSampleFrameId = 0;
+
+		mutable FCriticalSection SamplesCS;
+		FStageSamples Samples[NumStages];
+		double WindowStartTime = 0.0;
+	};
+} // namespace UE::PixelStreaming
@@ -0,0 +1,250 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PixelStreamingRoiMap.h"
+#include "FrameRoiMap.h"
+#include "Framework/Application/IInputProcessor.h"
+#include "Framework/Application/SlateApplication.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RenderUtils.h"
+#include "RHIGPUReadback.h"
+#include "SceneRenderTargetParameters.h"
+#include "UnrealClient.h"
+
+namespace UE::PixelStreaming
+{
+	static TAutoConsoleVariable<bool> CVarPixelStreamingEncoderRoi(
+		TEXT("PixelStreaming.Encoder.Roi"),
+		false,
+		TEXT("If true, a per-macroblock QP offset map is derived from DasCustom (selected and highlighted objects) and recent clicks for encoders that support ROI encoding."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<int32> CVarPixelStreamingEncoderRoiQPOffset(
+		TEXT("PixelStreaming.Encoder.Roi.QPOffset"),
+		-6,
+		TEXT("QP offset of macroblocks covering selected or highlighted objects and focus points. Negative spends more bits."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<int32> CVarPixelStreamingEncoderRoiBackgroundQPOffset(
+		TEXT("PixelStreaming.Encoder.Roi.BackgroundQPOffset"),
+		2,
+		TEXT("QP offset of every other macroblock, so the bits given to the ROI are taken from the background at the same bitrate."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarPixelStreamingEncoderRoiFocusSeconds(
+		TEXT("PixelStreaming.Encoder.Roi.FocusSeconds"),
+		1.0f,
+		TEXT("How long a click or pick location stays a region of interest. 0 disables focus points."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<int32> CVarPixelStreamingEncoderRoiFocusRadius(
+		TEXT("PixelStreaming.Encoder.Roi.FocusRadius"),
+		96,
+		TEXT("Radius in frame pixels around a focus point that counts as region of interest."),
+		ECVF_Default);
+
+	/** Counts clicks, the position is taken from the streamed viewport under the mouse when it is rendered. */
+	class FRoiMap::FInputProcessor : public IInputProcessor
+	{
+	public:
+		virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override {}
+
+		virtual bool HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override
+		{
+			if (IsEnabled())
+			{
+				++FRoiMap::Get().ClickCount;
+			}
+			return false;
+		}
+
+		virtual const TCHAR* GetDebugName() const override { return TEXT("PixelStreamingRoiMap"); }
+	};
+
+	FRoiMap& FRoiMap::Get()
+	{
+		static FRoiMap RoiMap;
+		return RoiMap;
+	}
+
+	bool FRoiMap::IsEnabled()
+	{
+		return CVarPixelStreamingEncoderRoi.GetValueOnAnyThread();
+	}
+
+	void FRoiMap::Initialize()
+	{
+		check(IsInGameThread());
+		if (bInitialized || !FSlateApplication::IsInitialized())
+		{
+			return;
+		}
+
+		FSlateApplication::Get().RegisterInputPreProcessor(MakeShared<FInputProcessor>());
+		bInitialized = true;
+	}
+
+	void FRoiMap::OnViewportRendered(FViewport* Viewport)
+	{
+		if (!Viewport)
+		{
+			return;
+		}
+
+		// 每个视口记住自己看到的点击数，点击只算给鼠标下的视口
+		const uint32 CurrentClickCount = ClickCount;
+		bool bNewClick = false;
+		{
+			FScopeLock Lock(&CS);
+			if (FViewportState* State = ViewportStates.Find(Viewport))
+			{
+				bNewClick = State->SeenClickCount != CurrentClickCount;
+				State->SeenClickCount = CurrentClickCount;
+			}
+			else
+			{
+				ViewportStates.Add(Viewport).SeenClickCount = CurrentClickCount;
+			}
+		}
+
+		if (bNewClick)
+		{
+			FIntPoint MousePos;
+			Viewport->GetMousePos(MousePos);
+			const FIntPoint Size = Viewport->GetSizeXY();
+			if (MousePos.X >= 0 && MousePos.Y >= 0 && MousePos.X < Size.X && MousePos.Y < Size.Y)
+			{
+				AddFocusPoint(Viewport, MousePos);
+			}
+		}
+	}
+
+	void FRoiMap::AddFocusPoint(const FViewport* Viewport, FIntPoint FramePixel)
+	{
+		if (!IsEnabled() || CVarPixelStreamingEncoderRoiFocusSeconds.GetValueOnAnyThread() <= 0.0f)
+		{
+			return;
+		}
+
+		FScopeLock Lock(&CS);
+		TArray<FFocusPoint>& FocusPoints = ViewportStates.FindOrAdd(Viewport).FocusPoints;
+		if (FocusPoints.Num() >= FrameRoiMapMaxFocusPoints)
+		{
+			FocusPoints.RemoveAt(0);
+		}
+		FocusPoints.Add({ FramePixel, FPlatformTime::Seconds() });
+	}
+
+	void FRoiMap::ProcessReadbacks(const FViewport* Viewport)
+	{
+		TArray<FPendingMap>* Readbacks = PendingReadbacks.Find(Viewport);
+		while (Readbacks && Readbacks->Num() > 0 && (*Readbacks)[0].Readback->IsReady())
+		{
+			FPendingMap Pending = MoveTemp((*Readbacks)[0]);
+			Readbacks->RemoveAt(0);
+
+			const int32 NumBlocks = Pending.NumBlocks.X * Pending.NumBlocks.Y;
+			const int32* QPOffsets = static_cast<const int32*>(Pending.Readback->Lock(NumBlocks * sizeof(int32)));
+
+			FScopeLock Lock(&CS);
+			FViewportState& State = ViewportStates.FindOrAdd(Viewport);
+			State.LatestNumBlocks = Pending.NumBlocks;
+			State.LatestQPOffsets.SetNumUninitialized(NumBlocks);
+			for (int32 Index = 0; Index < NumBlocks; ++Index)
+			{
+				State.LatestQPOffsets[Index] = (int8)FMath::Clamp(QPOffsets[Index], -51, 51);
+			}
+
+			Pending.Readback->Unlock();
+		}
+	}
+
+	void FRoiMap::Update(FRHICommandListImmediate& RHICmdList, const FViewport* Viewport, FIntPoint FrameExtent)
+	{
+		ProcessReadbacks(Viewport);
+
+		TArray<FPendingMap>& Readbacks = PendingReadbacks.FindOrAdd(Viewport);
+		if (Readbacks.Num() >= MaxPendingReadbacks || FrameExtent.X <= 0 || FrameExtent.Y <= 0)
+		{
+			return;
+		}
+
+		FFrameRoiMapSettings Settings;
+		Settings.FrameExtent = FrameExtent;
+		Settings.RoiQPOffset = CVarPixelStreamingEncoderRoiQPOffset.GetValueOnRenderThread();
+		Settings.BackgroundQPOffset = CVarPixelStreamingEncoderRoiBackgroundQPOffset.GetValueOnRenderThread();
+		Settings.FocusRadius = CVarPixelStreamingEncoderRoiFocusRadius.GetValueOnRenderThread();
+		{
+			const double ExpireTime = FPlatformTime::Seconds() - CVarPixelStreamingEncoderRoiFocusSeconds.GetValueOnRenderThread();
+			FScopeLock Lock(&CS);
+			if (FViewportState* State = ViewportStates.Find(Viewport))
+			{
+				State->FocusPoints.RemoveAll([ExpireTime](const FFocusPoint& Point) { return Point.Time < ExpireTime; });
+				for (const FFocusPoint& Point : State->FocusPoints)
+				{
+					Settings.FocusPoints.Add(Point.FramePixel);
+				}
+			}
+		}
+
+		// 这个视口自己那次场景渲染的DasCustom，没有自定义深度时只剩焦点
+		const FDasTextureExtracts* DasExtracts = GetDasTextureExtracts(Viewport);
+		FRHITexture* DasCustom = DasExtracts ? DasExtracts->GetDasCustom() : nullptr;
+		if (DasCustom == nullptr && Settings.FocusPoints.Num() == 0)
+		{
+			FScopeLock Lock(&CS);
+			if (FViewportState* State = ViewportStates.Find(Viewport))
+			{
+				State->LatestNumBlocks = FIntPoint::ZeroValue;
+				State->LatestQPOffsets.Reset();
+			}
+			return;
+		}
+
+		FRDGBuilder GraphBuilder(RHICmdList);
+
+		FRDGTextureRef DasCustomTexture;
+		if (DasCustom)
+		{
+			DasCustomTexture = GraphBuilder.RegisterExternalTexture(DasExtracts->DasCustom, TEXT("PixelStreamingDasCustom"));
+			Settings.MaskRect = FIntRect(DasExtracts->ViewRect.Min, DasExtracts->ViewRect.Max.ComponentMin(DasCustomTexture->Desc.Extent));
+		}
+		else
+		{
+			DasCustomTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(GBlackTexture->TextureRHI, TEXT("PixelStreamingDasCustomDummy")));
+		}
+
+		FRDGBufferRef QPOffsets = AddFrameRoiMapPass(GraphBuilder, DasCustomTexture, Settings);
+
+		FPendingMap& Pending = Readbacks.AddDefaulted_GetRef();
+		Pending.Readback = MakeUnique<FRHIGPUBufferReadback>(TEXT("PixelStreamingRoiMap"));
+		Pending.NumBlocks = GetFrameRoiMapNumBlocks(FrameExtent);
+		AddEnqueueCopyPass(GraphBuilder, Pending.Readback.Get(), QPOffsets, 0u);
+
+		GraphBuilder.Execute();
+	}
+
+	bool FRoiMap::GetLatest(const FViewport* Viewport, FIntPoint& OutNumBlocks, TArray<int8>& OutQPOffsets) const
+	{
+		FScopeLock Lock(&CS);
+		const FViewportState* State = ViewportStates.Find(Viewport);
+		if (State == nullptr || State->LatestQPOffsets.Num() == 0)
+		{
+			return false;
+		}
+
+		OutNumBlocks = State->LatestNumBlocks;
+		OutQPOffsets = State->LatestQPOffsets;
+		return true;
+	}
+
+	void FRoiMap::RemoveViewport(const FViewport* Viewport)
+	{
+		check(IsInRenderingThread());
+		PendingReadbacks.Remove(Viewport);
+
+		FScopeLock Lock(&CS);
+		ViewportStates.Remove(Viewport);
+	}
+} // namespace UE::PixelStreaming
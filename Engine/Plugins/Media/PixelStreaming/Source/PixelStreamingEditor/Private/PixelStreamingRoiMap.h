@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FRHICommandListImmediate;
+class FRHIGPUBufferReadback;
+class FViewport;
+
+namespace UE::PixelStreaming
+{
+	/**
+	 * Per-macroblock QP offsets for encoders that support regions of interest, derived on the GPU from the DasCustom texture
+	 * of the streamed viewport's own scene render (selected and highlighted objects) and from recent click positions. Maps are read back asynchronously, so the latest map
+	 * describes a frame a few frames old, which is close enough for objects the user is looking at. Focus points, readbacks and
+	 * maps are kept per streamed viewport.
+	 */
+	class FRoiMap
+	{
+	public:
+		static FRoiMap& Get();
+		static bool IsEnabled();
+
+		/** Hooks clicks so they become focus points. Game thread only, safe to call more than once. */
+		void Initialize();
+
+		/** Turns a click since the viewport's last call into a focus point if the mouse is over the viewport. Game thread. */
+		void OnViewportRendered(FViewport* Viewport);
+
+		/** Marks a frame pixel of the viewport, e.g. a pick location, as ROI for PixelStreaming.Encoder.Roi.FocusSeconds. Any thread. */
+		void AddFocusPoint(const FViewport* Viewport, FIntPoint FramePixel);
+
+		/** Computes the map of a frame of the viewport about to be encoded and collects its finished readbacks. Render thread. */
+		void Update(FRHICommandListImmediate& RHICmdList, const FViewport* Viewport, FIntPoint FrameExtent);
+
+		/** Latest map of the viewport, one QP offset per 16x16 block row by row. Returns false if there is none. Any thread. */
+		bool GetLatest(const FViewport* Viewport, FIntPoint& OutNumBlocks, TArray<int8>& OutQPOffsets) const;
+
+		/** Drops the state of a viewport that is no longer streamed. Render thread, after its last Update. */
+		void RemoveViewport(const FViewport* Viewport);
+
+	private:
+		void ProcessReadbacks(const FViewport* Viewport);
+
+		struct FFocusPoint
+		{
+			FIntPoint FramePixel;
+			double Time = 0.0;
+		};
+
+		struct FPendingMap
+		{
+			TUniquePtr<FRHIGPUBufferReadback> Readback;
+			FIntPoint NumBlocks = FIntPoint::ZeroValue;
+		};
+
+		struct FViewportState
+		{
+			TArray<FFocusPoint> FocusPoints;
+			TArray<int8> LatestQPOffsets;
+			FIntPoint LatestNumBlocks = FIntPoint::ZeroValue;
+
+			/** ClickCount when the viewport was last rendered. */
+			uint32 SeenClickCount = 0;
+		};
+
+		static constexpr int32 MaxPendingReadbacks = 4;
+
+		class FInputProcessor;
+		friend class FInputProcessor;
+
+		bool bInitialized = false;
+		std::atomic<uint32> ClickCount { 0 };
+
+		// Render thread.
+		TMap<const FViewport*, TArray<FPendingMap>> PendingReadbacks;
+
+		mutable FCriticalSection CS;
+		TMap<const FViewport*, FViewportState> ViewportStates;
+	};
+} // namespace UE::PixelStreaming
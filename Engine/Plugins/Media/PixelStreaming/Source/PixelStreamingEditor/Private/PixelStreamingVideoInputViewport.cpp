@@ -1,6 +1,9 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "PixelStreamingVideoInputViewport.h"
+#include "PixelStreamingLatencyTracker.h"
+#include "PixelStreamingRoiMap.h"
+#include "PixelStreamingIdMap.h"
 #include "Settings.h"
 #include "Utils.h"
 #include "PixelCaptureInputFrameRHI.h"
@@ -14,6 +17,227 @@
 #include "Framework/Application/SlateApplication.h"
 #include "Slate/SceneViewport.h"
 #include "IPixelStreamingModule.h"
+#include "FrameTileHash.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIGPUReadback.h"
+#include "SceneRenderTargetParameters.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/Async.h"
+
+namespace UE::PixelStreaming
+{
+	static TAutoConsoleVariable<bool> CVarPixelStreamingSkipStaticFrames(
+		TEXT("PixelStreaming.Capture.SkipStaticFrames"),
+		false,
+		TEXT("If true, viewport frames whose GPU tile hashes match the previous frame are not passed on to the encoder."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<float> CVarPixelStreamingStaticFrameKeepAlive(
+		TEXT("PixelStreaming.Capture.StaticFrameKeepAliveSeconds"),
+		1.0f,
+		TEXT("While static frames are skipped, a frame is still sent at least this often (in seconds) so new peers and keyframe requests are served."),
+		ECVF_Default);
+
+	/**
+	 * Detects unchanged viewport frames by comparing per-tile hashes computed on the GPU.
+	 * Hashes are read back asynchronously, so a change is noticed a few frames late. The first frame after a change is noticed is
+	 * always sent, which guarantees the final state of every change reaches the encoder.
+	 */
+	class FStaticFrameDetector
+	{
+	public:
+		/** Hashes the frame and returns whether it can be skipped. Render thread only. */
+		bool ShouldSkipFrame(FRHICommandListImmediate& RHICmdList, FRHITexture* FrameBuffer);
+
+		/** Pixel bounds of the tiles that changed in the most recently compared frame. Empty if nothing changed. */
+		const FIntRect& GetChangedRegion() const { return ChangedRegion; }
+
+	private:
+		void ProcessReadbacks();
+
+		struct FPendingTileHashes
+		{
+			TUniquePtr<FRHIGPUBufferReadback> Readback;
+			FIntPoint NumTiles = FIntPoint::ZeroValue;
+		};
+
+		static constexpr int32 MaxPendingReadbacks = 4;
+
+		TArray<FPendingTileHashes> PendingReadbacks;
+		TArray<uint32> PreviousTileHashes;
+		FIntPoint PreviousNumTiles = FIntPoint::ZeroValue;
+		FIntRect ChangedRegion;
+		int32 NumUnchangedFrames = 0;
+		bool bChangedSinceLastSend = true;
+		double LastSentTime = 0.0;
+	};
+
+	void FStaticFrameDetector::ProcessReadbacks()
+	{
+		while (PendingReadbacks.Num() > 0 && PendingReadbacks[0].Readback->IsReady())
+		{
+			FPendingTileHashes Pending = MoveTemp(PendingReadbacks[0]);
+			PendingReadbacks.RemoveAt(0);
+
+			const int32 NumTileHashes = Pending.NumTiles.X * Pending.NumTiles.Y;
+			const uint32* TileHashes = static_cast<const uint32*>(Pending.Readback->Lock(NumTileHashes * sizeof(uint32)));
+
+			if (Pending.NumTiles != PreviousNumTiles)
+			{
+				// Resized, treat the whole frame as changed.
+				ChangedRegion = FIntRect(FIntPoint::ZeroValue, Pending.NumTiles * FrameTileHashTileSize);
+			}
+			else
+			{
+				FIntPoint ChangedMin(MAX_int32, MAX_int32);
+				FIntPoint ChangedMax(MIN_int32, MIN_int32);
+				for (int32 TileIndex = 0; TileIndex < NumTileHashes; ++TileIndex)
+				{
+					if (TileHashes[TileIndex] != PreviousTileHashes[TileIndex])
+					{
+						const FIntPoint Tile(TileIndex % Pending.NumTiles.X, TileIndex / Pending.NumTiles.X);
+						ChangedMin = ChangedMin.ComponentMin(Tile);
+						ChangedMax = ChangedMax.ComponentMax(Tile + 1);
+					}
+				}
+
+				ChangedRegion = ChangedMax.X > ChangedMin.X
+					? FIntRect(ChangedMin * FrameTileHashTileSize, ChangedMax * FrameTileHashTileSize)
+					: FIntRect();
+			}
+
+			PreviousTileHashes = TArray<uint32>(TileHashes, NumTileHashes);
+			PreviousNumTiles = Pending.NumTiles;
+			Pending.Readback->Unlock();
+
+			if (ChangedRegion.IsEmpty())
+			{
+				++NumUnchangedFrames;
+			}
+			else
+			{
+				NumUnchangedFrames = 0;
+				bChangedSinceLastSend = true;
+			}
+		}
+	}
+
+	bool FStaticFrameDetector::ShouldSkipFrame(FRHICommandListImmediate& RHICmdList, FRHITexture* FrameBuffer)
+	{
+		ProcessReadbacks();
+
+		// Without a hash for this frame we can't vouch for it later, so it must be sent.
+		bool bHashed = false;
+		if (PendingReadbacks.Num() < MaxPendingReadbacks)
+		{
+			FRDGBuilder GraphBuilder(RHICmdList);
+
+			FRDGTextureRef FrameTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(FrameBuffer, TEXT("PixelStreamingFrame")));
+			FRDGBufferRef TileHashes = AddFrameTileHashPass(GraphBuilder, FrameTexture);
+
+			FPendingTileHashes& Pending = PendingReadbacks.AddDefaulted_GetRef();
+			Pending.Readback = MakeUnique<FRHIGPUBufferReadback>(TEXT("PixelStreamingFrameTileHashes"));
+			Pending.NumTiles = GetFrameTileHashNumTiles(FrameTexture->Desc.Extent);
+			AddEnqueueCopyPass(GraphBuilder, Pending.Readback.Get(), TileHashes, 0u);
+
+			// The capturer copies from the frame after us.
+			GraphBuilder.SetTextureAccessFinal(FrameTexture, ERHIAccess::SRVMask);
+			GraphBuilder.Execute();
+
+			bHashed = true;
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		const bool bKeepAliveDue = Now - LastSentTime >= CVarPixelStreamingStaticFrameKeepAlive.GetValueOnRenderThread();
+		if (bHashed && NumUnchangedFrames > 0 && !bChangedSinceLastSend && !bKeepAliveDue)
+		{
+			return true;
+		}
+
+		LastSentTime = Now;
+		bChangedSinceLastSend = false;
+		return false;
+	}
+
+	// Detector state per captured viewport, only touched on the render thread.
+	static TMap<const FViewport*, TUniquePtr<FStaticFrameDetector>> GStaticFrameDetectors;
+
+	// Widgets of the streamed viewports, only touched on the game thread. Per-viewport state is dropped once the widget is gone.
+	static TMap<const FViewport*, TWeakPtr<SViewport>> GStreamedViewportWidgets;
+
+	// Every live viewport input, only touched on the game thread.
+	static TArray<TWeakPtr<FPixelStreamingVideoInputViewport>> GViewportInputs;
+
+	// The input capturing each viewport, only touched on the game thread. Streamers of later inputs watching the same viewport are
+	// handed over to it, so its capturer copies and converts every frame once per format and simulcast layer for all of them.
+	static TMap<const FViewport*, TWeakPtr<FPixelStreamingVideoInputViewport>> GSharedViewportInputs;
+
+	// Streamers handed over to the shared input of a viewport, only touched on the game thread.
+	static TMap<const FViewport*, TArray<TWeakPtr<IPixelStreamingStreamer>>> GSharedViewportStreamers;
+
+	// Whether the streamer is streaming the scene viewport. The caller has checked the viewport type.
+	static bool StreamerTargetsViewport(const TSharedPtr<IPixelStreamingStreamer>& Streamer, const FViewport* InViewport)
+	{
+		if (!Streamer.IsValid() || !Streamer->IsStreaming())
+		{
+			return false;
+		}
+
+		TSharedPtr<SViewport> TargetScene = Streamer->GetTargetViewport().Pin();
+		return TargetScene.IsValid() && TargetScene == StaticCast<const FSceneViewport*>(InViewport)->GetViewportWidget().Pin();
+	}
+
+	// Viewports whose Das textures are extracted for the ID and ROI maps, only touched on the render thread.
+	static TSet<const FViewport*> GDasExtractViewports;
+
+	static void SetDasExtractsWanted(const FViewport* Viewport, bool bWanted)
+	{
+		if (bWanted && !GDasExtractViewports.Contains(Viewport))
+		{
+			GDasExtractViewports.Add(Viewport);
+			AddDasTextureExtractsUser(Viewport);
+		}
+		else if (!bWanted && GDasExtractViewports.Remove(Viewport) > 0)
+		{
+			RemoveDasTextureExtractsUser(Viewport);
+		}
+	}
+
+	static void RemoveStreamedViewports(TArray<const FViewport*>&& Viewports)
+	{
+		if (Viewports.Num() > 0)
+		{
+			ENQUEUE_RENDER_COMMAND(RemoveStreamedViewports)
+			([Viewports = MoveTemp(Viewports)](FRHICommandList& RHICmdList) {
+				for (const FViewport* Viewport : Viewports)
+				{
+					GStaticFrameDetectors.Remove(Viewport);
+					FRoiMap::Get().RemoveViewport(Viewport);
+					FIdMapStreamer::Get().RemoveViewport(Viewport);
+					SetDasExtractsWanted(Viewport, false);
+				}
+			});
+		}
+	}
+
+	// Game thread. Drops the per-viewport state of viewports whose widget went away, or all of them once no input is left.
+	static void PruneStreamedViewports()
+	{
+		TArray<const FViewport*> Removed;
+		for (auto It = GStreamedViewportWidgets.CreateIterator(); It; ++It)
+		{
+			if (GViewportInputs.Num() == 0 || !It.Value().IsValid())
+			{
+				Removed.Add(It.Key());
+				GSharedViewportInputs.Remove(It.Key());
+				GSharedViewportStreamers.Remove(It.Key());
+				It.RemoveCurrent();
+			}
+		}
+		RemoveStreamedViewports(MoveTemp(Removed));
+	}
+} // namespace UE::PixelStreaming
 
 TSharedPtr<FPixelStreamingVideoInputViewport> FPixelStreamingVideoInputViewport::Create(TSharedPtr<IPixelStreamingStreamer> InAssociatedStreamer)
 {
@@ -26,6 +250,10 @@ TSharedPtr<FPixelStreamingVideoInputViewport> FPixelStreamingVideoInputViewport:
 		if (TSharedPtr<FPixelStreamingVideoInputViewport> Input = WeakInput.Pin())
 		{
 			Input->DelegateHandle = UGameViewportClient::OnViewportRendered().AddSP(Input.ToSharedRef(), &FPixelStreamingVideoInputViewport::OnViewportRendered);
+			UE::PixelStreaming::GViewportInputs.Add(WeakInput);
+			UE::PixelStreaming::FLatencyTracker::Get().Initialize();
+			UE::PixelStreaming::FRoiMap::Get().Initialize();
+			UE::PixelStreaming::FIdMapStreamer::Get().Initialize();
 		}
 	});
 
@@ -38,24 +266,15 @@ FPixelStreamingVideoInputViewport::~FPixelStreamingVideoInputViewport()
 	{
 		UE::PixelStreaming::DoOnGameThread([HandleCopy = DelegateHandle]() {
 			UGameViewportClient::OnViewportRendered().Remove(HandleCopy);
+
+			UE::PixelStreaming::GViewportInputs.RemoveAll([](const TWeakPtr<FPixelStreamingVideoInputViewport>& Input) { return !Input.IsValid(); });
+			UE::PixelStreaming::PruneStreamedViewports();
 		});
 	}
 }
 
 bool FPixelStreamingVideoInputViewport::FilterViewport(const FViewport* InViewport)
 {
-	TSharedPtr<IPixelStreamingStreamer> Streamer = AssociatedStreamer.Pin();
-	if (!Streamer.IsValid() || !Streamer->IsStreaming())
-	{
-		return false;
-	}
-
-	TSharedPtr<SViewport> TargetScene = Streamer->GetTargetViewport().Pin();
-	if (!TargetScene.IsValid())
-	{
-		return false;
-	}
-
 	if (InViewport == nullptr)
 	{
 		return false;
@@ -67,22 +286,78 @@ bool FPixelStreamingVideoInputViewport::FilterViewport(const FViewport* InViewpo
 	}
 
 	// Bit dirty to do a static cast here, but we check viewport type just above so it is somewhat "safe".
-	TSharedPtr<SViewport> InScene = StaticCast<const FSceneViewport*>(InViewport)->GetViewportWidget().Pin();
-
 	// If the viewport we were passed is not our target viewport we are not interested in getting its texture.
-	if (TargetScene != InScene)
+	return UE::PixelStreaming::StreamerTargetsViewport(AssociatedStreamer.Pin(), InViewport);
+}
+
+void FPixelStreamingVideoInputViewport::OnViewportRendered(FViewport* InViewport)
+{
+	using namespace UE::PixelStreaming;
+
+	if (InViewport == nullptr || InViewport->GetViewportType() != TargetViewportType)
 	{
-		return false;
+		return;
 	}
 
+	// 视口控件销毁后丢掉它的状态，地址复用时不会沿用旧的帧哈希和共享输入
+	PruneStreamedViewports();
 
+	// 每个视口只有一个输入抓帧，第一个看它的输入负责
+	TSharedPtr<FPixelStreamingVideoInputViewport> SharedInput;
+	if (const TWeakPtr<FPixelStreamingVideoInputViewport>* WeakShared = GSharedViewportInputs.Find(InViewport))
+	{
+		SharedInput = WeakShared->Pin();
+	}
+	if (!SharedInput.IsValid())
+	{
+		const TWeakPtr<FPixelStreamingVideoInputViewport>* WeakSelf = GViewportInputs.FindByPredicate([this](const TWeakPtr<FPixelStreamingVideoInputViewport>& Input) { return Input.Pin().Get() == this; });
+		if (WeakSelf == nullptr || !FilterViewport(InViewport))
+		{
+			return;
+		}
+		GSharedViewportInputs.Add(InViewport, *WeakSelf);
+		SharedInput = WeakSelf->Pin();
+	}
 
-	return true;
-}
+	if (SharedInput.Get() != this)
+	{
+		// 把本streamer交给共享输入，它的捕获器为所有streamer只做一次拷贝和格式转换；本输入随后被streamer释放
+		if (FilterViewport(InViewport))
+		{
+			GSharedViewportStreamers.FindOrAdd(InViewport).AddUnique(AssociatedStreamer);
+			AsyncTask(ENamedThreads::GameThread, [WeakStreamer = AssociatedStreamer, WeakSharedInput = TWeakPtr<FPixelStreamingVideoInputViewport>(SharedInput)]() {
+				TSharedPtr<IPixelStreamingStreamer> Streamer = WeakStreamer.Pin();
+				TSharedPtr<FPixelStreamingVideoInputViewport> Input = WeakSharedInput.Pin();
+				if (Streamer.IsValid() && Input.IsValid())
+				{
+					Streamer->SetVideoInput(Input);
+				}
+			});
+		}
+		return;
+	}
 
-void FPixelStreamingVideoInputViewport::OnViewportRendered(FViewport* InViewport)
-{
-	if (!FilterViewport(InViewport))
+	TArray<TWeakPtr<IPixelStreamingStreamer>> Streamers;
+	if (FilterViewport(InViewport))
+	{
+		Streamers.Add(AssociatedStreamer);
+	}
+	if (TArray<TWeakPtr<IPixelStreamingStreamer>>* HandedOver = GSharedViewportStreamers.Find(InViewport))
+	{
+		HandedOver->RemoveAll([&SharedInput](const TWeakPtr<IPixelStreamingStreamer>& WeakStreamer) {
+			TSharedPtr<IPixelStreamingStreamer> Streamer = WeakStreamer.Pin();
+			return !Streamer.IsValid() || Streamer->GetVideoInput().Pin() != SharedInput;
+		});
+		for (const TWeakPtr<IPixelStreamingStreamer>& WeakStreamer : *HandedOver)
+		{
+			if (StreamerTargetsViewport(WeakStreamer.Pin(), InViewport))
+			{
+				Streamers.AddUnique(WeakStreamer);
+			}
+		}
+	}
+
+	if (Streamers.Num() == 0)
 	{
 		return;
 	}
@@ -94,9 +369,56 @@ void FPixelStreamingVideoInputViewport::OnViewportRendered(FViewport* InViewport
 		return;
 	}
 
+	const bool bSkipStaticFrames = UE::PixelStreaming::CVarPixelStreamingSkipStaticFrames.GetValueOnGameThread();
+	if (!UE::PixelStreaming::GStreamedViewportWidgets.Contains(InViewport))
+	{
+		// FilterViewport已经确认是场景视口
+		UE::PixelStreaming::GStreamedViewportWidgets.Add(InViewport, StaticCast<const FSceneViewport*>(InViewport)->GetViewportWidget());
+	}
+
+	const UE::PixelStreaming::FFrameLatencyStamps LatencyStamps = UE::PixelStreaming::FLatencyTracker::Get().StampRenderSubmit();
+	UE::PixelStreaming::FRoiMap::Get().OnViewportRendered(InViewport);
+
 	ENQUEUE_RENDER_COMMAND(StreamViewportTextureCommand)
-	([&, FrameBuffer](FRHICommandList& RHICmdList) {
-		OnFrame(FPixelCaptureInputFrameRHI(FrameBuffer));
+	([InViewport, bSkipStaticFrames, FrameBuffer, WeakInput = TWeakPtr<FPixelStreamingVideoInputViewport>(SharedInput), Streamers = MoveTemp(Streamers), LatencyStamps](FRHICommandListImmediate& RHICmdList) {
+		// 视口自己的Das图，下一次场景渲染起才有
+		const bool bIdMap = UE::PixelStreaming::FIdMapStreamer::IsEnabled();
+		UE::PixelStreaming::SetDasExtractsWanted(InViewport, bIdMap || UE::PixelStreaming::FRoiMap::IsEnabled());
+
+		// 低分辨率ID图按自己的间隔发送，静态画面下也要定期发关键图
+		if (bIdMap)
+		{
+			UE::PixelStreaming::FIdMapStreamer::Get().Update(RHICmdList, InViewport, FrameBuffer->GetSizeXY(), Streamers);
+		}
+
+		// 静态画面不送编码器，空闲场景不再占用编码带宽
+		if (bSkipStaticFrames)
+		{
+			TUniquePtr<UE::PixelStreaming::FStaticFrameDetector>& Detector = UE::PixelStreaming::GStaticFrameDetectors.FindOrAdd(InViewport);
+			if (!Detector)
+			{
+				Detector = MakeUnique<UE::PixelStreaming::FStaticFrameDetector>();
+			}
+
+			if (Detector->ShouldSkipFrame(RHICmdList, FrameBuffer))
+			{
+				return;
+			}
+		}
+
+		// 编码器的ROI图，只为真正送去编码的帧计算
+		if (UE::PixelStreaming::FRoiMap::IsEnabled())
+		{
+			UE::PixelStreaming::FRoiMap::Get().Update(RHICmdList, InViewport, FrameBuffer->GetSizeXY());
+		}
+
+		// 所有streamer共用这个输入的捕获器，每种格式和分层只转换一次
+		if (TSharedPtr<FPixelStreamingVideoInputViewport> Input = WeakInput.Pin())
+		{
+			Input->OnFrame(FPixelCaptureInputFrameRHI(FrameBuffer));
+		}
+
+		UE::PixelStreaming::FLatencyTracker::Get().RecordCapture(LatencyStamps);
 	});
 }
 
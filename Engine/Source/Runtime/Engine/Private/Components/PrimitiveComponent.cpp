@@ -45,6 +45,7 @@
 #include "UObject/ObjectSaveContext.h"
 #include "Engine/DamageEvents.h"
 #include "MeshUVChannelInfo.h"
+#include "DasPickAccelerator.h"
 
 #if WITH_EDITOR
 #include "Engine/LODActor.h"
@@ -581,6 +582,9 @@ void UPrimitiveComponent::CreateRenderState_Concurrent(FRegisterComponentContext
 
 	UpdateBounds();
 
+	//add Das CPU拾取的包围盒树
+	FDasPickAccelerator::NotifyPrimitiveChanged(this);
+
 	// If the primitive isn't hidden and the detail mode setting allows it, add it to the scene.
 	if (ShouldComponentAddToScene()
 #ifdef WITH_EDITOR
@@ -622,6 +626,9 @@ void UPrimitiveComponent::SendRenderTransform_Concurrent()
 {
 	UpdateBounds();
 
+	//add Das
+	FDasPickAccelerator::NotifyPrimitiveChanged(this);
+
 	// If the primitive isn't hidden update its transform.
 	const bool bDetailModeAllowsRendering	= DetailMode <= GetCachedScalabilityCVars().DetailMode;
 	if( bDetailModeAllowsRendering && (ShouldRender() || bCastHiddenShadow || bAffectIndirectLightingWhileHidden || bRayTracingFarField))
@@ -781,6 +788,9 @@ void UPrimitiveComponent::DestroyRenderState_Concurrent()
 		World->Scene->RemovePrimitive(this);
 	}
 
+	//add Das
+	FDasPickAccelerator::NotifyPrimitiveChanged(this);
+
 	Super::DestroyRenderState_Concurrent();
 }
 
@@ -4321,6 +4331,7 @@ void UPrimitiveComponent::SetDasStencilValue(int32 Value)
 	if (DasStencilValue != Value)
 	{
 		DasStencilValue = Value;
+		FDasPickAccelerator::NotifyPrimitiveChanged(this);
 		if (SceneProxy)
 		{
 			SceneProxy->SetDasStencilValue_GameThread(DasStencilValue);
@@ -0,0 +1,907 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DasPickAccelerator.h"
+#include "HAL/IConsoleManager.h"
+#include "Algo/Sort.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "ConvexVolume.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "StaticMeshResources.h"
+#include "UObject/UObjectGlobals.h"
+
+DECLARE_CYCLE_STAT(TEXT("Das CPU Ray Pick"), STAT_DasCpuRayPick, STATGROUP_Engine);
+DECLARE_CYCLE_STAT(TEXT("Das CPU Frustum Pick"), STAT_DasCpuFrustumPick, STATGROUP_Engine);
+DECLARE_CYCLE_STAT(TEXT("Das CPU Pick Build Mesh BVH"), STAT_DasCpuPickBuildMeshBVH, STATGROUP_Engine);
+
+static bool GDasCpuPick = true;
+static FAutoConsoleVariableRef CVarDasCpuPick(
+	TEXT("r.Das.CpuPick"),
+	GDasCpuPick,
+	TEXT("If true, components in the Das ID path are kept in a bounds tree so FDasPickAccelerator can pick them on the CPU, without physics or a DasStencil readback."),
+	ECVF_Default
+	);
+
+static bool GDasCpuPickBoundsFallback = true;
+static FAutoConsoleVariableRef CVarDasCpuPickBoundsFallback(
+	TEXT("r.Das.CpuPick.BoundsFallback"),
+	GDasCpuPickBoundsFallback,
+	TEXT("If true, components without CPU triangle data (not static meshes, or cooked meshes without bAllowCPUAccess) are picked by their bounds with batch ID 0."),
+	ECVF_Default
+	);
+
+static float GDasCpuPickBoundsMargin = 0.1f;
+static FAutoConsoleVariableRef CVarDasCpuPickBoundsMargin(
+	TEXT("r.Das.CpuPick.BoundsMargin"),
+	GDasCpuPickBoundsMargin,
+	TEXT("Fraction of its extent a component's box in the bounds tree is enlarged by, so small movements do not reinsert it."),
+	ECVF_Default
+	);
+
+/** Triangle BVH of a static mesh LOD0 in local space. Every node covers a contiguous range of triangles. */
+struct FDasPickMeshBVH
+{
+	struct FTriangle
+	{
+		FVector3f Vertices[3];
+		int32 BatchID = 0;
+	};
+
+	struct FNode
+	{
+		FBox3f Box;
+		int32 Start = 0;
+		int32 Count = 0;
+		int32 Left = INDEX_NONE;
+	};
+
+	static constexpr int32 MaxLeafTriangles = 4;
+
+	const FStaticMeshRenderData* RenderData = nullptr;
+	TArray<FTriangle> Triangles;
+	TArray<FNode> Nodes;
+
+	bool IsValid() const { return Nodes.Num() > 0; }
+
+	void Build()
+	{
+		if (Triangles.Num() > 0)
+		{
+			Nodes.Reserve(Triangles.Num() * 2 / MaxLeafTriangles + 1);
+			Nodes.AddDefaulted();
+			BuildNode(0, 0, Triangles.Num());
+		}
+	}
+
+	void BuildNode(int32 NodeIndex, int32 Start, int32 Count)
+	{
+		FBox3f Box(ForceInit);
+		FBox3f CentroidBox(ForceInit);
+		for (int32 Index = Start; Index < Start + Count; ++Index)
+		{
+			const FTriangle& Triangle = Triangles[Index];
+			Box += Triangle.Vertices[0];
+			Box += Triangle.Vertices[1];
+			Box += Triangle.Vertices[2];
+			CentroidBox += (Triangle.Vertices[0] + Triangle.Vertices[1] + Triangle.Vertices[2]) / 3.0f;
+		}
+
+		Nodes[NodeIndex].Box = Box;
+		Nodes[NodeIndex].Start = Start;
+		Nodes[NodeIndex].Count = Count;
+
+		const FVector3f CentroidSize = CentroidBox.GetSize();
+		const int32 Axis = CentroidSize.X > CentroidSize.Y ? (CentroidSize.X > CentroidSize.Z ? 0 : 2) : (CentroidSize.Y > CentroidSize.Z ? 1 : 2);
+		if (Count <= MaxLeafTriangles || CentroidSize[Axis] <= UE_KINDA_SMALL_NUMBER)
+		{
+			return;
+		}
+
+		// 按最长轴中位数二分
+		Algo::Sort(MakeArrayView(Triangles.GetData() + Start, Count), [Axis](const FTriangle& A, const FTriangle& B)
+		{
+			return A.Vertices[0][Axis] + A.Vertices[1][Axis] + A.Vertices[2][Axis] < B.Vertices[0][Axis] + B.Vertices[1][Axis] + B.Vertices[2][Axis];
+		});
+
+		const int32 Left = Nodes.AddDefaulted(2);
+		Nodes[NodeIndex].Left = Left;
+		const int32 LeftCount = Count / 2;
+		BuildNode(Left, Start, LeftCount);
+		BuildNode(Left + 1, Start + LeftCount, Count - LeftCount);
+	}
+};
+
+/** Slab test of the segment Start + Delta * t, t in [0, MaxTime]. */
+template<typename T>
+static bool IntersectSegmentBox(const UE::Math::TBox<T>& Box, const UE::Math::TVector<T>& Start, const UE::Math::TVector<T>& InvDelta, T MaxTime, T& OutTime)
+{
+	T MinT = 0;
+	T MaxT = MaxTime;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		T T0 = (Box.Min[Axis] - Start[Axis]) * InvDelta[Axis];
+		T T1 = (Box.Max[Axis] - Start[Axis]) * InvDelta[Axis];
+		if (T0 > T1)
+		{
+			Swap(T0, T1);
+		}
+		MinT = FMath::Max(MinT, T0);
+		MaxT = FMath::Min(MaxT, T1);
+		if (MinT > MaxT)
+		{
+			return false;
+		}
+	}
+	OutTime = MinT;
+	return true;
+}
+
+template<typename T>
+static UE::Math::TVector<T> GetSafeInverse(const UE::Math::TVector<T>& Delta)
+{
+	const T Big = T(1.0e30);
+	return UE::Math::TVector<T>(
+		FMath::Abs(Delta.X) > UE_SMALL_NUMBER ? T(1) / Delta.X : Big,
+		FMath::Abs(Delta.Y) > UE_SMALL_NUMBER ? T(1) / Delta.Y : Big,
+		FMath::Abs(Delta.Z) > UE_SMALL_NUMBER ? T(1) / Delta.Z : Big);
+}
+
+/** Two sided Moller-Trumbore, the pick should hit whatever the depth pass draws. */
+static bool IntersectSegmentTriangle(const FVector3f& Start, const FVector3f& Delta, const FVector3f Vertices[3], float MaxTime, float& OutTime)
+{
+	const FVector3f Edge1 = Vertices[1] - Vertices[0];
+	const FVector3f Edge2 = Vertices[2] - Vertices[0];
+	const FVector3f P = FVector3f::CrossProduct(Delta, Edge2);
+	const float Determinant = FVector3f::DotProduct(Edge1, P);
+	if (FMath::Abs(Determinant) < UE_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	const float InvDeterminant = 1.0f / Determinant;
+	const FVector3f S = Start - Vertices[0];
+	const float U = FVector3f::DotProduct(S, P) * InvDeterminant;
+	if (U < 0.0f || U > 1.0f)
+	{
+		return false;
+	}
+
+	const FVector3f Q = FVector3f::CrossProduct(S, Edge1);
+	const float V = FVector3f::DotProduct(Delta, Q) * InvDeterminant;
+	if (V < 0.0f || U + V > 1.0f)
+	{
+		return false;
+	}
+
+	const float Time = FVector3f::DotProduct(Edge2, Q) * InvDeterminant;
+	if (Time < 0.0f || Time > MaxTime)
+	{
+		return false;
+	}
+
+	OutTime = Time;
+	return true;
+}
+
+/** Closest triangle along a local space segment, returns its index or INDEX_NONE. */
+static int32 TraceMeshBVH(const FDasPickMeshBVH& BVH, const FVector3f& Start, const FVector3f& Delta, float& InOutBestTime)
+{
+	const FVector3f InvDelta = GetSafeInverse(Delta);
+	int32 BestTriangle = INDEX_NONE;
+
+	TArray<int32, TInlineAllocator<64>> Stack;
+	Stack.Add(0);
+	while (Stack.Num() > 0)
+	{
+		const FDasPickMeshBVH::FNode& Node = BVH.Nodes[Stack.Pop(false)];
+		float BoxTime;
+		if (!IntersectSegmentBox(Node.Box, Start, InvDelta, InOutBestTime, BoxTime))
+		{
+			continue;
+		}
+
+		if (Node.Left == INDEX_NONE)
+		{
+			for (int32 Index = Node.Start; Index < Node.Start + Node.Count; ++Index)
+			{
+				float Time;
+				if (IntersectSegmentTriangle(Start, Delta, BVH.Triangles[Index].Vertices, InOutBestTime, Time))
+				{
+					InOutBestTime = Time;
+					BestTriangle = Index;
+				}
+			}
+		}
+		else
+		{
+			Stack.Add(Node.Left);
+			Stack.Add(Node.Left + 1);
+		}
+	}
+
+	return BestTriangle;
+}
+
+static bool IntersectFrustumBox(const FConvexVolume& Frustum, const FBox& Box, bool& bOutFullyContained)
+{
+	return Frustum.IntersectBox(Box.GetCenter(), Box.GetExtent(), bOutFullyContained);
+}
+
+/** Collects the batch IDs of triangles whose bounds overlap the frustum. */
+static void CollectMeshBVHBatchIDs(const FDasPickMeshBVH& BVH, const FTransform& LocalToWorld, const FConvexVolume& Frustum, TSet<int32>& OutBatchIDs)
+{
+	TArray<int32, TInlineAllocator<64>> Stack;
+	Stack.Add(0);
+	while (Stack.Num() > 0)
+	{
+		const FDasPickMeshBVH::FNode& Node = BVH.Nodes[Stack.Pop(false)];
+		bool bFullyContained = false;
+		if (!IntersectFrustumBox(Frustum, FBox(Node.Box).TransformBy(LocalToWorld), bFullyContained))
+		{
+			continue;
+		}
+
+		if (bFullyContained || Node.Left == INDEX_NONE)
+		{
+			for (int32 Index = Node.Start; Index < Node.Start + Node.Count; ++Index)
+			{
+				const FDasPickMeshBVH::FTriangle& Triangle = BVH.Triangles[Index];
+				if (!bFullyContained && !OutBatchIDs.Contains(Triangle.BatchID))
+				{
+					FBox TriangleBox(ForceInit);
+					TriangleBox += LocalToWorld.TransformPosition(FVector(Triangle.Vertices[0]));
+					TriangleBox += LocalToWorld.TransformPosition(FVector(Triangle.Vertices[1]));
+					TriangleBox += LocalToWorld.TransformPosition(FVector(Triangle.Vertices[2]));
+					bool bTriangleContained;
+					if (!IntersectFrustumBox(Frustum, TriangleBox, bTriangleContained))
+					{
+						continue;
+					}
+				}
+				OutBatchIDs.Add(Triangle.BatchID);
+			}
+		}
+		else
+		{
+			Stack.Add(Node.Left);
+			Stack.Add(Node.Left + 1);
+		}
+	}
+}
+
+static bool GetInstanceBatchID(const UInstancedStaticMeshComponent* InstancedComponent, int32 InstanceIndex, int32& OutBatchID)
+{
+	// 与DepthOnlyVertexShader一致，实例自定义数据0覆盖UV7的BatchID
+	const int32 DataIndex = InstanceIndex * InstancedComponent->NumCustomDataFloats;
+	if (InstancedComponent->NumCustomDataFloats > 0 && InstancedComponent->PerInstanceSMCustomData.IsValidIndex(DataIndex))
+	{
+		OutBatchID = FMath::RoundToInt32(InstancedComponent->PerInstanceSMCustomData[DataIndex]);
+		return true;
+	}
+	return false;
+}
+
+FDasPickAccelerator& FDasPickAccelerator::Get()
+{
+	static FDasPickAccelerator Accelerator;
+	return Accelerator;
+}
+
+FDasPickAccelerator::FDasPickAccelerator()
+{
+}
+
+void FDasPickAccelerator::NotifyPrimitiveChanged(const UPrimitiveComponent* Component)
+{
+	if (GDasCpuPick && Component && (Component->bRenderCustomDepth || Component->DasStencilValue != 0))
+	{
+		FDasPickAccelerator& Accelerator = Get();
+		FScopeLock Lock(&Accelerator.PendingCriticalSection);
+		Accelerator.PendingComponents.Add(FObjectKey(Component));
+	}
+}
+
+bool FDasPickAccelerator::IsPickable(const UPrimitiveComponent* Component, const UWorld* World) const
+{
+	// 不看渲染线程状态，专用服务器和-nullrhi下没有场景代理也要能拾取
+	return Component
+		&& Component->IsRegistered()
+		&& Component->IsVisible()
+		&& !(Component->bHiddenInGame && Component->GetWorld() && Component->GetWorld()->IsGameWorld())
+		&& (Component->bRenderCustomDepth || Component->DasStencilValue != 0)
+		&& (World == nullptr || Component->GetWorld() == World);
+}
+
+void FDasPickAccelerator::FlushPendingChanges()
+{
+	check(IsInGameThread());
+
+	if (!bDelegatesRegistered)
+	{
+		bDelegatesRegistered = true;
+		FWorldDelegates::OnWorldCleanup.AddRaw(this, &FDasPickAccelerator::OnWorldCleanup);
+		FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FDasPickAccelerator::OnPostGarbageCollect);
+	}
+
+	TSet<FObjectKey> Pending;
+	{
+		FScopeLock Lock(&PendingCriticalSection);
+		Pending = MoveTemp(PendingComponents);
+		PendingComponents.Reset();
+	}
+
+	if (!GDasCpuPick)
+	{
+		if (Leaves.Num() > 0)
+		{
+			Reset();
+		}
+		return;
+	}
+
+	for (const FObjectKey& ComponentKey : Pending)
+	{
+		UPrimitiveComponent* Component = Cast<UPrimitiveComponent>(ComponentKey.ResolveObjectPtr());
+		if (IsPickable(Component, nullptr))
+		{
+			UpdateComponent(Component);
+		}
+		else
+		{
+			RemoveComponent(ComponentKey);
+		}
+	}
+}
+
+int32 FDasPickAccelerator::AllocateNode()
+{
+	if (FreeList != INDEX_NONE)
+	{
+		const int32 NodeIndex = FreeList;
+		FreeList = Nodes[NodeIndex].Parent;
+		Nodes[NodeIndex] = FNode();
+		return NodeIndex;
+	}
+	return Nodes.AddDefaulted();
+}
+
+void FDasPickAccelerator::FreeNode(int32 NodeIndex)
+{
+	Nodes[NodeIndex] = FNode();
+	Nodes[NodeIndex].Parent = FreeList;
+	FreeList = NodeIndex;
+}
+
+static double GetSurfaceArea(const FBox& Box)
+{
+	const FVector Size = Box.GetSize();
+	return 2.0 * (Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X);
+}
+
+void FDasPickAccelerator::InsertLeaf(int32 Leaf)
+{
+	if (Root == INDEX_NONE)
+	{
+		Root = Leaf;
+		Nodes[Leaf].Parent = INDEX_NONE;
+		return;
+	}
+
+	// 按表面积启发选择兄弟节点
+	const FBox LeafBox = Nodes[Leaf].Box;
+	int32 Sibling = Root;
+	while (!Nodes[Sibling].IsLeaf())
+	{
+		const FNode& Node = Nodes[Sibling];
+		const double Area = GetSurfaceArea(Node.Box);
+		const double CombinedArea = GetSurfaceArea(Node.Box + LeafBox);
+		const double Cost = 2.0 * CombinedArea;
+		const double InheritanceCost = 2.0 * (CombinedArea - Area);
+
+		double ChildCosts[2];
+		for (int32 ChildIndex = 0; ChildIndex < 2; ++ChildIndex)
+		{
+			const FNode& Child = Nodes[Node.Children[ChildIndex]];
+			const double ChildArea = GetSurfaceArea(Child.Box + LeafBox);
+			ChildCosts[ChildIndex] = (Child.IsLeaf() ? ChildArea : ChildArea - GetSurfaceArea(Child.Box)) + InheritanceCost;
+		}
+
+		if (Cost < ChildCosts[0] && Cost < ChildCosts[1])
+		{
+			break;
+		}
+		Sibling = Node.Children[ChildCosts[0] < ChildCosts[1] ? 0 : 1];
+	}
+
+	const int32 OldParent = Nodes[Sibling].Parent;
+	const int32 NewParent = AllocateNode();
+	Nodes[NewParent].Parent = OldParent;
+	Nodes[NewParent].Box = Nodes[Sibling].Box + LeafBox;
+	Nodes[NewParent].Children[0] = Sibling;
+	Nodes[NewParent].Children[1] = Leaf;
+	Nodes[Sibling].Parent = NewParent;
+	Nodes[Leaf].Parent = NewParent;
+
+	if (OldParent == INDEX_NONE)
+	{
+		Root = NewParent;
+	}
+	else
+	{
+		FNode& Parent = Nodes[OldParent];
+		Parent.Children[Parent.Children[0] == Sibling ? 0 : 1] = NewParent;
+	}
+
+	for (int32 Index = OldParent; Index != INDEX_NONE; Index = Nodes[Index].Parent)
+	{
+		Nodes[Index].Box = Nodes[Nodes[Index].Children[0]].Box + Nodes[Nodes[Index].Children[1]].Box;
+	}
+}
+
+void FDasPickAccelerator::RemoveLeaf(int32 Leaf)
+{
+	if (Leaf == Root)
+	{
+		Root = INDEX_NONE;
+		return;
+	}
+
+	const int32 Parent = Nodes[Leaf].Parent;
+	const int32 GrandParent = Nodes[Parent].Parent;
+	const int32 Sibling = Nodes[Parent].Children[Nodes[Parent].Children[0] == Leaf ? 1 : 0];
+
+	if (GrandParent == INDEX_NONE)
+	{
+		Root = Sibling;
+		Nodes[Sibling].Parent = INDEX_NONE;
+	}
+	else
+	{
+		FNode& GrandParentNode = Nodes[GrandParent];
+		GrandParentNode.Children[GrandParentNode.Children[0] == Parent ? 0 : 1] = Sibling;
+		Nodes[Sibling].Parent = GrandParent;
+
+		for (int32 Index = GrandParent; Index != INDEX_NONE; Index = Nodes[Index].Parent)
+		{
+			Nodes[Index].Box = Nodes[Nodes[Index].Children[0]].Box + Nodes[Nodes[Index].Children[1]].Box;
+		}
+	}
+
+	FreeNode(Parent);
+}
+
+void FDasPickAccelerator::RemoveComponent(FObjectKey ComponentKey)
+{
+	int32 Leaf;
+	if (Leaves.RemoveAndCopyValue(ComponentKey, Leaf))
+	{
+		RemoveLeaf(Leaf);
+		FreeNode(Leaf);
+	}
+}
+
+void FDasPickAccelerator::UpdateComponent(UPrimitiveComponent* Component)
+{
+	const FBox Box = Component->Bounds.GetBox();
+	const FObjectKey ComponentKey(Component);
+
+	int32* ExistingLeaf = Leaves.Find(ComponentKey);
+	if (ExistingLeaf && Nodes[*ExistingLeaf].Box.IsInside(Box))
+	{
+		return;
+	}
+
+	int32 Leaf;
+	if (ExistingLeaf)
+	{
+		Leaf = *ExistingLeaf;
+		RemoveLeaf(Leaf);
+	}
+	else
+	{
+		Leaf = AllocateNode();
+		Leaves.Add(ComponentKey, Leaf);
+		Nodes[Leaf].Component = Component;
+		Nodes[Leaf].ComponentKey = ComponentKey;
+		Nodes[Leaf].World = FObjectKey(Component->GetWorld());
+	}
+
+	// 叶子包围盒外扩，小幅移动不必重新插入
+	Nodes[Leaf].Box = Box.ExpandBy(Box.GetExtent() * GDasCpuPickBoundsMargin + FVector(1.0));
+	InsertLeaf(Leaf);
+}
+
+TSharedPtr<const FDasPickMeshBVH> FDasPickAccelerator::FindOrBuildMeshBVH(UStaticMesh* StaticMesh)
+{
+	const FStaticMeshRenderData* RenderData = StaticMesh ? StaticMesh->GetRenderData() : nullptr;
+	if (RenderData == nullptr || RenderData->LODResources.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	const FObjectKey MeshKey(StaticMesh);
+	if (const TSharedPtr<const FDasPickMeshBVH>* Existing = MeshBVHs.Find(MeshKey))
+	{
+		if ((*Existing)->RenderData == RenderData)
+		{
+			return *Existing;
+		}
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DasCpuPickBuildMeshBVH);
+
+	TSharedPtr<FDasPickMeshBVH> BVH = MakeShared<FDasPickMeshBVH>();
+	BVH->RenderData = RenderData;
+
+	// 烘焙版本只有bAllowCPUAccess的网格保留顶点与索引的CPU副本
+	const FStaticMeshLODResources& LOD = RenderData->LODResources[0];
+	const FPositionVertexBuffer& Positions = LOD.VertexBuffers.PositionVertexBuffer;
+	const FStaticMeshVertexBuffer& StaticMeshVertexBuffer = LOD.VertexBuffers.StaticMeshVertexBuffer;
+	const FIndexArrayView Indices = LOD.IndexBuffer.GetArrayView();
+	const bool bHasCPUData = (WITH_EDITOR || StaticMesh->bAllowCPUAccess) && Positions.GetVertexData() != nullptr && Indices.Num() > 0;
+	const bool bHasBatchIDs = StaticMeshVertexBuffer.GetNumTexCoords() > 7 && StaticMeshVertexBuffer.GetTexCoordData() != nullptr;
+
+	if (bHasCPUData)
+	{
+		const uint32 NumVertices = Positions.GetNumVertices();
+		BVH->Triangles.Reserve(Indices.Num() / 3);
+		for (int32 Index = 0; Index + 2 < Indices.Num(); Index += 3)
+		{
+			FDasPickMeshBVH::FTriangle Triangle;
+			bool bValid = true;
+			for (int32 Corner = 0; Corner < 3; ++Corner)
+			{
+				const uint32 VertexIndex = Indices[Index + Corner];
+				if (VertexIndex >= NumVertices)
+				{
+					bValid = false;
+					break;
+				}
+				Triangle.Vertices[Corner] = Positions.VertexPosition(VertexIndex);
+			}
+
+			if (bValid)
+			{
+				if (bHasBatchIDs)
+				{
+					const FVector2f BatchUV = StaticMeshVertexBuffer.GetVertexUV(Indices[Index], 7);
+					Triangle.BatchID = FMath::RoundToInt32(BatchUV.X * 1024.0f + BatchUV.Y);
+				}
+				BVH->Triangles.Add(Triangle);
+			}
+		}
+		BVH->Build();
+	}
+
+	MeshBVHs.Add(MeshKey, BVH);
+	return BVH;
+}
+
+bool FDasPickAccelerator::PickComponent(UPrimitiveComponent* Component, const FVector& Start, const FVector& End, double& InOutBestTime, FDasPickHit& OutHit)
+{
+	const UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Component);
+	const TSharedPtr<const FDasPickMeshBVH> BVH = StaticMeshComponent ? FindOrBuildMeshBVH(StaticMeshComponent->GetStaticMesh()) : nullptr;
+
+	if (!BVH.IsValid() || !BVH->IsValid())
+	{
+		double BoxTime;
+		const FVector Delta = End - Start;
+		if (!GDasCpuPickBoundsFallback || !IntersectSegmentBox(Component->Bounds.GetBox(), Start, GetSafeInverse(Delta), InOutBestTime, BoxTime))
+		{
+			return false;
+		}
+
+		InOutBestTime = BoxTime;
+		OutHit = FDasPickHit();
+		OutHit.Component = Component;
+		OutHit.Location = Start + Delta * BoxTime;
+		return true;
+	}
+
+	auto TraceInstance = [&BVH, &Start, &End, &InOutBestTime](const FTransform& LocalToWorld, FVector OutVertices[3], int32& OutTriangle)
+	{
+		// 在局部空间求交，线段参数与世界空间一致
+		const FVector3f LocalStart(LocalToWorld.InverseTransformPosition(Start));
+		const FVector3f LocalDelta = FVector3f(LocalToWorld.InverseTransformPosition(End)) - LocalStart;
+		float BestTime = (float)InOutBestTime;
+		const int32 Triangle = TraceMeshBVH(*BVH, LocalStart, LocalDelta, BestTime);
+		if (Triangle == INDEX_NONE)
+		{
+			return false;
+		}
+
+		InOutBestTime = BestTime;
+		OutTriangle = Triangle;
+		for (int32 Corner = 0; Corner < 3; ++Corner)
+		{
+			OutVertices[Corner] = LocalToWorld.TransformPosition(FVector(BVH->Triangles[Triangle].Vertices[Corner]));
+		}
+		return true;
+	};
+
+	FVector HitVertices[3];
+	int32 HitTriangle = INDEX_NONE;
+	int32 HitInstance = INDEX_NONE;
+
+	if (const UInstancedStaticMeshComponent* InstancedComponent = Cast<UInstancedStaticMeshComponent>(Component))
+	{
+		const int32 NumInstances = InstancedComponent->GetInstanceCount();
+		for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+		{
+			FTransform InstanceToWorld;
+			if (InstancedComponent->GetInstanceTransform(InstanceIndex, InstanceToWorld, true) && TraceInstance(InstanceToWorld, HitVertices, HitTriangle))
+			{
+				HitInstance = InstanceIndex;
+			}
+		}
+	}
+	else if (TraceInstance(Component->GetComponentTransform(), HitVertices, HitTriangle))
+	{
+		HitInstance = INDEX_NONE;
+	}
+
+	if (HitTriangle == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutHit = FDasPickHit();
+	OutHit.Component = Component;
+	OutHit.BatchID = BVH->Triangles[HitTriangle].BatchID;
+	OutHit.InstanceIndex = HitInstance;
+	OutHit.Location = Start + (End - Start) * InOutBestTime;
+	OutHit.Normal = FVector::CrossProduct(HitVertices[2] - HitVertices[0], HitVertices[1] - HitVertices[0]).GetSafeNormal();
+	if (FVector::DotProduct(OutHit.Normal, End - Start) > 0.0)
+	{
+		OutHit.Normal = -OutHit.Normal;
+	}
+	OutHit.bTriangleHit = true;
+
+	if (HitInstance != INDEX_NONE)
+	{
+		GetInstanceBatchID(CastChecked<UInstancedStaticMeshComponent>(Component), HitInstance, OutHit.BatchID);
+	}
+	return true;
+}
+
+bool FDasPickAccelerator::RayPick(const UWorld* World, const FVector& Start, const FVector& End, FDasPickHit& OutHit)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DasCpuRayPick);
+
+	FlushPendingChanges();
+	if (Root == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FObjectKey WorldKey(World);
+	const FVector InvDelta = GetSafeInverse(End - Start);
+	double BestTime = 1.0;
+	bool bHit = false;
+	TArray<FObjectKey, TInlineAllocator<8>> StaleComponents;
+
+	TArray<int32, TInlineAllocator<64>> Stack;
+	Stack.Add(Root);
+	while (Stack.Num() > 0)
+	{
+		const int32 NodeIndex = Stack.Pop(false);
+		double BoxTime;
+		if (!IntersectSegmentBox(Nodes[NodeIndex].Box, Start, InvDelta, BestTime, BoxTime))
+		{
+			continue;
+		}
+
+		if (!Nodes[NodeIndex].IsLeaf())
+		{
+			Stack.Add(Nodes[NodeIndex].Children[0]);
+			Stack.Add(Nodes[NodeIndex].Children[1]);
+			continue;
+		}
+
+		if (Nodes[NodeIndex].World != WorldKey)
+		{
+			continue;
+		}
+
+		UPrimitiveComponent* Component = Nodes[NodeIndex].Component.Get();
+		if (!IsPickable(Component, World))
+		{
+			// 隐藏或取消自定义深度时没有变换通知，查询时移除
+			StaleComponents.Add(Nodes[NodeIndex].ComponentKey);
+			continue;
+		}
+
+		FDasPickHit ComponentHit;
+		if (PickComponent(Component, Start, End, BestTime, ComponentHit))
+		{
+			OutHit = ComponentHit;
+			bHit = true;
+		}
+	}
+
+	for (const FObjectKey& ComponentKey : StaleComponents)
+	{
+		RemoveComponent(ComponentKey);
+	}
+
+	if (bHit)
+	{
+		UPrimitiveComponent* Component = OutHit.Component.Get();
+		OutHit.DasStencilValue = Component->DasStencilValue;
+		OutHit.Distance = (End - Start).Size() * BestTime;
+	}
+	return bHit;
+}
+
+void FDasPickAccelerator::FrustumPickComponent(UPrimitiveComponent* Component, const FConvexVolume& Frustum, TArray<FDasPickHit>& OutHits)
+{
+	auto AddHit = [Component, &OutHits](int32 BatchID, int32 InstanceIndex, bool bTriangleHit)
+	{
+		FDasPickHit& Hit = OutHits.AddDefaulted_GetRef();
+		Hit.Component = Component;
+		Hit.DasStencilValue = Component->DasStencilValue;
+		Hit.BatchID = BatchID;
+		Hit.InstanceIndex = InstanceIndex;
+		Hit.bTriangleHit = bTriangleHit;
+	};
+
+	const UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Component);
+	const TSharedPtr<const FDasPickMeshBVH> BVH = StaticMeshComponent ? FindOrBuildMeshBVH(StaticMeshComponent->GetStaticMesh()) : nullptr;
+
+	if (!BVH.IsValid() || !BVH->IsValid())
+	{
+		if (GDasCpuPickBoundsFallback)
+		{
+			AddHit(0, INDEX_NONE, false);
+		}
+		return;
+	}
+
+	TSet<int32> BatchIDs;
+	if (const UInstancedStaticMeshComponent* InstancedComponent = Cast<UInstancedStaticMeshComponent>(Component))
+	{
+		const FBox MeshBox(BVH->Nodes[0].Box);
+		const int32 NumInstances = InstancedComponent->GetInstanceCount();
+		for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+		{
+			FTransform InstanceToWorld;
+			bool bFullyContained;
+			if (!InstancedComponent->GetInstanceTransform(InstanceIndex, InstanceToWorld, true) || !IntersectFrustumBox(Frustum, MeshBox.TransformBy(InstanceToWorld), bFullyContained))
+			{
+				continue;
+			}
+
+			int32 BatchID;
+			if (GetInstanceBatchID(InstancedComponent, InstanceIndex, BatchID))
+			{
+				AddHit(BatchID, InstanceIndex, true);
+			}
+			else
+			{
+				BatchIDs.Reset();
+				CollectMeshBVHBatchIDs(*BVH, InstanceToWorld, Frustum, BatchIDs);
+				for (int32 MeshBatchID : BatchIDs)
+				{
+					AddHit(MeshBatchID, InstanceIndex, true);
+				}
+			}
+		}
+		return;
+	}
+
+	CollectMeshBVHBatchIDs(*BVH, Component->GetComponentTransform(), Frustum, BatchIDs);
+	for (int32 BatchID : BatchIDs)
+	{
+		AddHit(BatchID, INDEX_NONE, true);
+	}
+}
+
+void FDasPickAccelerator::FrustumPick(const UWorld* World, const FConvexVolume& Frustum, TArray<FDasPickHit>& OutHits)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DasCpuFrustumPick);
+
+	OutHits.Reset();
+	FlushPendingChanges();
+	if (Root == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FObjectKey WorldKey(World);
+	TArray<FObjectKey, TInlineAllocator<8>> StaleComponents;
+
+	TArray<int32, TInlineAllocator<64>> Stack;
+	Stack.Add(Root);
+	while (Stack.Num() > 0)
+	{
+		const int32 NodeIndex = Stack.Pop(false);
+		bool bFullyContained;
+		if (!IntersectFrustumBox(Frustum, Nodes[NodeIndex].Box, bFullyContained))
+		{
+			continue;
+		}
+
+		if (!Nodes[NodeIndex].IsLeaf())
+		{
+			Stack.Add(Nodes[NodeIndex].Children[0]);
+			Stack.Add(Nodes[NodeIndex].Children[1]);
+			continue;
+		}
+
+		if (Nodes[NodeIndex].World != WorldKey)
+		{
+			continue;
+		}
+
+		UPrimitiveComponent* Component = Nodes[NodeIndex].Component.Get();
+		if (!IsPickable(Component, World))
+		{
+			StaleComponents.Add(Nodes[NodeIndex].ComponentKey);
+			continue;
+		}
+
+		if (IntersectFrustumBox(Frustum, Component->Bounds.GetBox(), bFullyContained))
+		{
+			FrustumPickComponent(Component, Frustum, OutHits);
+		}
+	}
+
+	for (const FObjectKey& ComponentKey : StaleComponents)
+	{
+		RemoveComponent(ComponentKey);
+	}
+}
+
+void FDasPickAccelerator::Reset()
+{
+	Nodes.Reset();
+	Leaves.Reset();
+	MeshBVHs.Reset();
+	Root = INDEX_NONE;
+	FreeList = INDEX_NONE;
+}
+
+void FDasPickAccelerator::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	const FObjectKey WorldKey(World);
+	TArray<FObjectKey> WorldComponents;
+	for (const TPair<FObjectKey, int32>& Leaf : Leaves)
+	{
+		if (Nodes[Leaf.Value].World == WorldKey)
+		{
+			WorldComponents.Add(Leaf.Key);
+		}
+	}
+
+	for (const FObjectKey& ComponentKey : WorldComponents)
+	{
+		RemoveComponent(ComponentKey);
+	}
+}
+
+void FDasPickAccelerator::OnPostGarbageCollect()
+{
+	// 网格被回收后释放其BVH，组件被回收后移除其叶子
+	for (auto It = MeshBVHs.CreateIterator(); It; ++It)
+	{
+		if (It.Key().ResolveObjectPtr() == nullptr)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	TArray<FObjectKey> CollectedComponents;
+	for (const TPair<FObjectKey, int32>& Leaf : Leaves)
+	{
+		if (!Nodes[Leaf.Value].Component.IsValid())
+		{
+			CollectedComponents.Add(Leaf.Key);
+		}
+	}
+
+	for (const FObjectKey& ComponentKey : CollectedComponents)
+	{
+		RemoveComponent(ComponentKey);
+	}
+}
@@ -65,6 +65,12 @@
 #include "RenderTargetPool.h"
 #include "RenderGraphBuilder.h"
 #include "CustomResourcePool.h"
+#include "PrimitiveSceneProxy.h"
+#include "TickRateGovernor.h"
+#include "HitchRecorder.h"
+#include "StartupTimeline.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
 
 #if WITH_EDITOR
 #include "PIEPreviewDeviceProfileSelectorModule.h"
@@ -99,6 +105,143 @@ static FAutoConsoleVariableRef CVarDoAsyncEndOfFrameTasks(
 	TEXT("Experimental option to run various things concurrently with the HUD render.")
 	);
 
+static TAutoConsoleVariable<int32> CVarRenderOnDemand(
+	TEXT("r.RenderOnDemand"),
+	0,
+	TEXT("If 1, the game viewport is only redrawn after the camera, scene primitives, user input, viewport size, streaming or the remote viewer count changed, otherwise the last frame is presented again.\n")
+	TEXT("Frames that draw world position offset animation or primitives that always output velocity count as changed.\n")
+	TEXT("Set it at startup (ini or -dpcvars) so the game viewport gets its own render target to present again."),
+	ECVF_RenderThreadSafe
+	);
+
+static float GRenderOnDemandIdleMaxTickRate = 5.0f;
+static FAutoConsoleVariableRef CVarRenderOnDemandIdleMaxTickRate(
+	TEXT("r.RenderOnDemand.IdleMaxTickRate"),
+	GRenderOnDemandIdleMaxTickRate,
+	TEXT("Max tick rate while render on demand has nothing to redraw (<= 0 to keep the normal rate). Input is picked up at this rate, so keep it high enough to feel responsive."),
+	ECVF_Default
+	);
+
+static int32 GRenderOnDemandSettleFrames = 30;
+static FAutoConsoleVariableRef CVarRenderOnDemandSettleFrames(
+	TEXT("r.RenderOnDemand.SettleFrames"),
+	GRenderOnDemandSettleFrames,
+	TEXT("Frames still rendered after the last change so temporal AA, motion blur and eye adaptation can settle."),
+	ECVF_Default
+	);
+
+static float GRenderOnDemandStreamingMinRedrawRate = 2.0f;
+static FAutoConsoleVariableRef CVarRenderOnDemandStreamingMinRedrawRate(
+	TEXT("r.RenderOnDemand.StreamingMinRedrawRate"),
+	GRenderOnDemandStreamingMinRedrawRate,
+	TEXT("Redraws per second render on demand still does while remote viewers are connected (see t.TickRateGovernor viewer count), so the stream keeps sending frames (<= 0 to disable)."),
+	ECVF_Default
+	);
+
+static FAutoConsoleCommand CmdRenderOnDemandInvalidate(
+	TEXT("r.RenderOnDemand.Invalidate"),
+	TEXT("Forces render on demand to redraw, e.g. after material parameters changed."),
+	FConsoleCommandDelegate::CreateStatic(&FPrimitiveSceneProxy::NotifySceneChanged)
+	);
+
+/** What render on demand compares between frames to detect a change. Game thread only. */
+struct FRenderOnDemandState
+{
+	struct FCamera
+	{
+		FVector Location;
+		FRotator Rotation;
+		float FOV;
+
+		bool operator==(const FCamera& Other) const { return Location == Other.Location && Rotation == Other.Rotation && FOV == Other.FOV; }
+	};
+
+	TArray<FCamera, TInlineAllocator<4>> Cameras;
+	uint32 SceneChangeRevision = 0;
+	double LastUserInteractionTime = 0.0;
+	FIntPoint ViewportSize = FIntPoint::ZeroValue;
+	int32 ViewerCount = INDEX_NONE;
+	double LastRedrawTime = 0.0;
+	int32 FramesToRender = 1;
+	bool bIdle = false;
+};
+static FRenderOnDemandState GRenderOnDemandState;
+
+/** Returns whether the game viewport has to be redrawn this frame. Always true unless r.RenderOnDemand is on. */
+static bool ShouldRedrawOnDemand(UGameViewportClient* GameViewport)
+{
+	FRenderOnDemandState& State = GRenderOnDemandState;
+	if (CVarRenderOnDemand.GetValueOnGameThread() == 0 || GameViewport == nullptr)
+	{
+		State.bIdle = false;
+		return true;
+	}
+
+	bool bChanged = false;
+
+	// 代理增删、移动、Das选中/高亮等场景变化
+	const uint32 SceneChangeRevision = FPrimitiveSceneProxy::GetSceneChangeRevision();
+	bChanged |= SceneChangeRevision != State.SceneChangeRevision;
+	State.SceneChangeRevision = SceneChangeRevision;
+
+	// Slate input also covers UI interaction that changes what the game draws.
+	const double LastUserInteractionTime = FSlateApplication::IsInitialized() ? FSlateApplication::Get().GetLastUserInteractionTime() : 0.0;
+	bChanged |= LastUserInteractionTime != State.LastUserInteractionTime;
+	State.LastUserInteractionTime = LastUserInteractionTime;
+
+	const FIntPoint ViewportSize = GameViewport->Viewport ? GameViewport->Viewport->GetSizeXY() : FIntPoint::ZeroValue;
+	bChanged |= ViewportSize != State.ViewportSize;
+	State.ViewportSize = ViewportSize;
+
+	TArray<FRenderOnDemandState::FCamera, TInlineAllocator<4>> Cameras;
+	if (UGameInstance* GameInstance = GameViewport->GetGameInstance())
+	{
+		for (ULocalPlayer* LocalPlayer : GameInstance->GetLocalPlayers())
+		{
+			APlayerController* PlayerController = LocalPlayer ? LocalPlayer->PlayerController.Get() : nullptr;
+			if (PlayerController && PlayerController->PlayerCameraManager)
+			{
+				APlayerCameraManager* CameraManager = PlayerController->PlayerCameraManager;
+				Cameras.Add({ CameraManager->GetCameraLocation(), CameraManager->GetCameraRotation(), CameraManager->GetFOVAngle() });
+			}
+		}
+	}
+	bChanged |= Cameras != State.Cameras;
+	State.Cameras = MoveTemp(Cameras);
+
+	// 纹理和关卡流送未完成时画面还会继续变化
+	UWorld* World = GameViewport->GetWorld();
+	bChanged |= IStreamingManager::Get().GetNumWantingResources() > 0 || (World && World->IsVisibilityRequestPending());
+
+	// 远端观众接入或断开时重绘，新观众需要一帧完整画面
+	const int32 ViewerCount = FTickRateGovernor::Get().GetViewerCount();
+	bChanged |= ViewerCount != State.ViewerCount;
+	State.ViewerCount = ViewerCount;
+
+	if (bChanged)
+	{
+		State.FramesToRender = FMath::Max(GRenderOnDemandSettleFrames, 1);
+	}
+
+	// 有远端观众时保持最低重绘频率，编码器不会长时间收不到帧
+	const double Now = FPlatformTime::Seconds();
+	if (State.FramesToRender == 0 && ViewerCount > 0 && GRenderOnDemandStreamingMinRedrawRate > 0.0f
+		&& Now - State.LastRedrawTime >= 1.0 / GRenderOnDemandStreamingMinRedrawRate)
+	{
+		State.FramesToRender = 1;
+	}
+
+	State.bIdle = State.FramesToRender == 0;
+	if (State.bIdle)
+	{
+		return false;
+	}
+
+	--State.FramesToRender;
+	State.LastRedrawTime = Now;
+	return true;
+}
+
 bool ParseResolution(const TCHAR* InResolution, uint32& OutX, uint32& OutY, int32& WindowMode);
 
 /** Benchmark results to the log */
@@ -199,6 +342,12 @@ void UGameEngine::CreateGameViewportWidget( UGameViewportClient* GameViewportCli
 {
 	bool bRenderDirectlyToWindow = (!StartupMovieCaptureHandle.IsValid() || IMovieSceneCaptureModule::Get().IsStereoAllowed()) && GIsDumpingMovie == 0;
 
+	// 按需渲染跳过重绘时需要视口自己的渲染目标保存上一帧，由Slate重新呈现
+	if (CVarRenderOnDemand.GetValueOnGameThread() != 0)
+	{
+		bRenderDirectlyToWindow = false;
+	}
+
 	TSharedRef<SOverlay> ViewportOverlayWidgetRef = SNew( SOverlay );
 
 	TSharedRef<SGameLayerManager> GameLayerManagerRef = SNew(SGameLayerManager)
@@ -587,6 +736,13 @@ TSharedRef<SWindow> UGameEngine::CreateGameWindow()
 		{
 			MaxWindowWidth = 1920000;
 			MaxWindowHeight = 1080000;
+
+			// 超过显卡最大纹理尺寸时场景贴图按r.ClampInternalBufferToMaxTextureSize降分辨率后放大
+			const int32 MaxTextureSize = int32(GetMax2DTextureDimension());
+			if (ResX > MaxTextureSize || ResY > MaxTextureSize)
+			{
+				UE_LOG(LogEngine, Warning, TEXT("Game window %dx%d exceeds the max texture dimension %d, scene textures will be rendered at a lower resolution and upscaled."), ResX, ResY, MaxTextureSize);
+			}
 		}
 	}
 
@@ -1106,6 +1262,7 @@ void UGameEngine::Init(IEngineLoop* InEngineLoop)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UGameEngine::Init);
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("UGameEngine Init"), STAT_GameEngineStartup, STATGROUP_LoadTime);
+	SCOPED_STARTUP_TIMELINE("UGameEngine::Init");
 
 	if (!GIsEditor)
 	{
@@ -1113,7 +1270,10 @@ void UGameEngine::Init(IEngineLoop* InEngineLoop)
 	}
 
 	// Call base.
-	UEngine::Init(InEngineLoop);
+	{
+		SCOPED_STARTUP_TIMELINE("UEngine::Init");
+		UEngine::Init(InEngineLoop);
+	}
 
 #if USE_NETWORK_PROFILER
 	FString NetworkProfilerTag;
@@ -1126,6 +1286,7 @@ void UGameEngine::Init(IEngineLoop* InEngineLoop)
 	// Load and apply user game settings
 	{
 		TRACE_CPUPROFILER_EVENT_SCOPE(InitGameUserSettings);
+		SCOPED_STARTUP_TIMELINE("InitGameUserSettings");
 		GetGameUserSettings()->LoadSettings();
 		GetGameUserSettings()->ApplyNonResolutionSettings();
 	}
@@ -1133,6 +1294,7 @@ void UGameEngine::Init(IEngineLoop* InEngineLoop)
 	// Create game instance.  For GameEngine, this should be the only GameInstance that ever gets created.
 	{
 		TRACE_CPUPROFILER_EVENT_SCOPE(InitGameInstance);
+		SCOPED_STARTUP_TIMELINE("InitGameInstance");
 		FSoftClassPath GameInstanceClassName = GetDefault<UGameMapsSettings>()->GameInstanceClass;
 		UClass* GameInstanceClass = (GameInstanceClassName.IsValid() ? LoadObject<UClass>(NULL, *GameInstanceClassName.ToString()) : UGameInstance::StaticClass());
 		
@@ -1167,6 +1329,7 @@ void UGameEngine::Init(IEngineLoop* InEngineLoop)
 	if(GIsClient)
 	{
 		TRACE_CPUPROFILER_EVENT_SCOPE(InitGameViewPortClient);
+		SCOPED_STARTUP_TIMELINE("InitGameViewportClient");
 		ViewportClient = NewObject<UGameViewportClient>(this, GameViewportClientClass);
 		ViewportClient->Init(*GameInstance->GetWorldContext(), GameInstance);
 		GameViewport = ViewportClient;
@@ -1179,15 +1342,26 @@ void UGameEngine::Init(IEngineLoop* InEngineLoop)
 	if(ViewportClient)
 	{
 		TRACE_CPUPROFILER_EVENT_SCOPE(AttachGameViewport);
+		SCOPED_STARTUP_TIMELINE("AttachGameViewport");
 		// This must be created before any gameplay code adds widgets
 		bool bWindowAlreadyExists = GameViewportWindow.IsValid();
 		if (!bWindowAlreadyExists)
 		{
+			SCOPED_STARTUP_TIMELINE("CreateGameWindow");
 			UE_LOG(LogEngine, Log, TEXT("GameWindow did not exist.  Was created"));
 			GameViewportWindow = CreateGameWindow();
 		}
 
-		CreateGameViewport( ViewportClient );
+		{
+			SCOPED_STARTUP_TIMELINE("CreateGameViewport");
+			CreateGameViewport( ViewportClient );
+		}
+
+		// 首帧显示时间取窗口的back buffer提交，无渲染器时(-nullrhi)以首帧渲染为准
+		if (FApp::CanEverRender() && GameViewportWindow.IsValid())
+		{
+			FStartupTimeline::Get().WaitForFirstPresent(GameViewportWindow.Pin().ToSharedRef());
+		}
 
 		if( !bWindowAlreadyExists )
 		{
@@ -1213,6 +1387,7 @@ void UGameEngine::Init(IEngineLoop* InEngineLoop)
 void UGameEngine::Start()
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UGameEngine::Start);
+	SCOPED_STARTUP_TIMELINE("UGameEngine::Start");
 	UE_LOG(LogInit, Display, TEXT("Starting Game."));
 
 	GameInstance->StartGameInstance();
@@ -1626,6 +1801,18 @@ float UGameEngine::GetMaxTickRate(float DeltaTime, bool bAllowFrameRateSmoothing
 		MaxTickRate = SuperTickRate;
 	}
 
+	// Let activity, viewer count and encoder back-pressure policies lower the rate.
+	if (FTickRateGovernor::IsEnabled() && !IsRunningDedicatedServer())
+	{
+		MaxTickRate = FTickRateGovernor::Get().Apply(MaxTickRate);
+	}
+
+	// 按需渲染空闲时只需低频tick检测变化
+	if (GRenderOnDemandState.bIdle && GRenderOnDemandIdleMaxTickRate > 0.0f)
+	{
+		MaxTickRate = MaxTickRate > 0.0f ? FMath::Min(MaxTickRate, GRenderOnDemandIdleMaxTickRate) : GRenderOnDemandIdleMaxTickRate;
+	}
+
 	return MaxTickRate;
 }
 
@@ -1658,6 +1845,19 @@ void UGameEngine::Tick( float DeltaSeconds, bool bIdleMode )
 		UE_LOG(LogEngine, Log, TEXT("Slow GT frame detected (GT frame %u, delta time %f s)"), GFrameCounter - 1, DeltaSeconds);
 	}
 
+	// DeltaSeconds measures the previous frame, so this closes that frame in the hitch recorder.
+	FHitchRecorder::Get().EndFrame(DeltaSeconds, GSlowFrameLoggingThreshold);
+
+	if (!FStartupTimeline::Get().IsComplete())
+	{
+		// 专用服务器不渲染，第一次tick就结束启动
+		if (IsRunningDedicatedServer())
+		{
+			FStartupTimeline::Get().MarkFirstFrameRendered();
+		}
+		FStartupTimeline::Get().Tick();
+	}
+
 	if (IsRunningDedicatedServer())
 	{
 		double CurrentTime = FPlatformTime::Seconds();
@@ -1886,7 +2086,8 @@ void UGameEngine::Tick( float DeltaSeconds, bool bIdleMode )
 		}
 	}
 
-	const bool bRenderingSuspended = IsRenderingSuspended();
+	// Nothing changed in render on demand mode is handled like suspended rendering, the viewport keeps its last frame.
+	const bool bRenderingSuspended = IsRenderingSuspended() || !ShouldRedrawOnDemand(GameViewport);
 
 	if (!bIdleMode && !IsRunningDedicatedServer() && !IsRunningCommandlet() && FEmbeddedCommunication::IsAwakeForRendering())
 	{
@@ -1897,6 +2098,8 @@ void UGameEngine::Tick( float DeltaSeconds, bool bIdleMode )
 
 			// Some tasks can only be done once we finish all scenes/viewports
 			GetRendererModule().PostRenderAllViewports();
+
+			FStartupTimeline::Get().MarkFirstFrameRendered();
 		}
 		else
 		{
@@ -1918,6 +2121,7 @@ void UGameEngine::Tick( float DeltaSeconds, bool bIdleMode )
 	{
 		// Update resource streaming after viewports have had a chance to update view information. Normal update.
 		QUICK_SCOPE_CYCLE_COUNTER(STAT_UGameEngine_Tick_IStreamingManager);
+		FHitchRecorderScope HitchRecorderScope(EHitchRecorderTiming::Streaming);
 		IStreamingManager::Get().Tick( DeltaSeconds );
 	}
 
@@ -0,0 +1,292 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HitchRecorder.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RHI.h"
+#include "RHICommandList.h"
+#include "RenderCore.h"
+#include "RenderGraphBuilder.h"
+#include "RenderResource.h"
+#include "UObject/UObjectGlobals.h"
+#include "EngineLogs.h"
+
+static bool GHitchRecorderEnabled = true;
+static FAutoConsoleVariableRef CVarHitchRecorderEnabled(
+	TEXT("t.HitchRecorder"),
+	GHitchRecorderEnabled,
+	TEXT("If true, per-frame timings are kept in a ring buffer and the frames around a slow frame (t.SlowFrameLoggingThreshold) are saved to Saved/Profiling/Hitches."),
+	ECVF_Default
+	);
+
+static int32 GHitchRecorderFrames = 300;
+static FAutoConsoleVariableRef CVarHitchRecorderFrames(
+	TEXT("t.HitchRecorder.Frames"),
+	GHitchRecorderFrames,
+	TEXT("Number of frames kept by the hitch recorder."),
+	ECVF_Default
+	);
+
+static int32 GHitchRecorderFramesAfterHitch = 30;
+static FAutoConsoleVariableRef CVarHitchRecorderFramesAfterHitch(
+	TEXT("t.HitchRecorder.FramesAfterHitch"),
+	GHitchRecorderFramesAfterHitch,
+	TEXT("Frames recorded after a hitch before the window is saved."),
+	ECVF_Default
+	);
+
+static float GHitchRecorderMinDumpInterval = 30.0f;
+static FAutoConsoleVariableRef CVarHitchRecorderMinDumpInterval(
+	TEXT("t.HitchRecorder.MinDumpInterval"),
+	GHitchRecorderMinDumpInterval,
+	TEXT("Minimum seconds between two saved hitch windows, so a burst of slow frames produces one file."),
+	ECVF_Default
+	);
+
+static const TCHAR* GetHitchRecorderTimingName(EHitchRecorderTiming Timing)
+{
+	switch (Timing)
+	{
+	case EHitchRecorderTiming::PrePass:				return TEXT("PrePassSetupMs");
+	case EHitchRecorderTiming::BasePass:			return TEXT("BasePassSetupMs");
+	case EHitchRecorderTiming::CustomDepth:			return TEXT("CustomDepthSetupMs");
+	case EHitchRecorderTiming::PrePassGPU:			return TEXT("PrePassGPUMs");
+	case EHitchRecorderTiming::BasePassGPU:			return TEXT("BasePassGPUMs");
+	case EHitchRecorderTiming::CustomDepthGPU:		return TEXT("CustomDepthGPUMs");
+	case EHitchRecorderTiming::GarbageCollection:	return TEXT("GarbageCollectionMs");
+	case EHitchRecorderTiming::Streaming:			return TEXT("StreamingMs");
+	default:										return TEXT("Unknown");
+	}
+}
+
+FHitchRecorder& FHitchRecorder::Get()
+{
+	static FHitchRecorder Recorder;
+	return Recorder;
+}
+
+FHitchRecorder::FHitchRecorder()
+{
+	for (std::atomic<int64>& PendingTiming : PendingTimingsMicroseconds)
+	{
+		PendingTiming = 0;
+	}
+
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddLambda([this]()
+	{
+		GarbageCollectStartTime = FPlatformTime::Seconds();
+	});
+	FCoreUObjectDelegates::GetPostGarbageCollect().AddLambda([this]()
+	{
+		AddTime(EHitchRecorderTiming::GarbageCollection, FPlatformTime::Seconds() - GarbageCollectStartTime);
+	});
+}
+
+void FHitchRecorder::AddTime(EHitchRecorderTiming Timing, double Seconds)
+{
+	PendingTimingsMicroseconds[(int32)Timing].fetch_add(int64(Seconds * 1000000.0), std::memory_order_relaxed);
+}
+
+void FHitchRecorder::EndFrame(float DeltaSeconds, float HitchThresholdSeconds)
+{
+	check(IsInGameThread());
+
+	const int32 NumFramesToKeep = GHitchRecorderEnabled ? FMath::Max(GHitchRecorderFrames, 0) : 0;
+	if (NumFramesToKeep != Capacity)
+	{
+		Frames.Empty(NumFramesToKeep);
+		NextFrameIndex = 0;
+		FramesUntilDump = 0;
+		Capacity = NumFramesToKeep;
+	}
+
+	if (Capacity == 0)
+	{
+		return;
+	}
+
+	FFrame Frame;
+	Frame.FrameCounter = GFrameCounter;
+	Frame.DeltaMs = DeltaSeconds * 1000.0f;
+	Frame.GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Frame.RenderThreadMs = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+	Frame.RHIThreadMs = FPlatformTime::ToMilliseconds(GRHIThreadTime);
+	Frame.GPUMs = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+	for (int32 TimingIndex = 0; TimingIndex < (int32)EHitchRecorderTiming::Num; ++TimingIndex)
+	{
+		Frame.TimingsMs[TimingIndex] = float(PendingTimingsMicroseconds[TimingIndex].exchange(0, std::memory_order_relaxed)) / 1000.0f;
+	}
+
+	if (Frames.Num() < Capacity)
+	{
+		Frames.Add(Frame);
+	}
+	else
+	{
+		Frames[NextFrameIndex] = Frame;
+	}
+	NextFrameIndex = (NextFrameIndex + 1) % Capacity;
+
+	const double Now = FPlatformTime::Seconds();
+	if (HitchThresholdSeconds > 0.0f && DeltaSeconds > HitchThresholdSeconds && FramesUntilDump == 0 && Now - LastDumpTime >= GHitchRecorderMinDumpInterval)
+	{
+		PendingHitchFrameCounter = GFrameCounter;
+		FramesUntilDump = FMath::Max(GHitchRecorderFramesAfterHitch, 0) + 1;
+	}
+
+	if (FramesUntilDump > 0 && --FramesUntilDump == 0)
+	{
+		Dump(PendingHitchFrameCounter);
+		LastDumpTime = Now;
+	}
+}
+
+float FHitchRecorder::GetLastFrameTimeMs(EHitchRecorderTiming Timing) const
+{
+	if (Frames.Num() == 0)
+	{
+		return 0.0f;
+	}
+
+	const int32 LastFrameIndex = (NextFrameIndex + Capacity - 1) % Capacity;
+	return Frames[LastFrameIndex].TimingsMs[(int32)Timing];
+}
+
+void FHitchRecorder::Dump(uint64 HitchFrameCounter) const
+{
+	FString Csv = TEXT("Frame,Hitch,DeltaMs,GameThreadMs,RenderThreadMs,RHIThreadMs,GPUMs");
+	for (int32 TimingIndex = 0; TimingIndex < (int32)EHitchRecorderTiming::Num; ++TimingIndex)
+	{
+		Csv += TEXT(",");
+		Csv += GetHitchRecorderTimingName((EHitchRecorderTiming)TimingIndex);
+	}
+	Csv += LINE_TERMINATOR;
+
+	// Oldest first.
+	const int32 FirstIndex = Frames.Num() < Capacity ? 0 : NextFrameIndex;
+	for (int32 Offset = 0; Offset < Frames.Num(); ++Offset)
+	{
+		const FFrame& Frame = Frames[(FirstIndex + Offset) % Frames.Num()];
+		Csv += FString::Printf(TEXT("%llu,%d,%.3f,%.3f,%.3f,%.3f,%.3f"),
+			Frame.FrameCounter, Frame.FrameCounter == HitchFrameCounter ? 1 : 0,
+			Frame.DeltaMs, Frame.GameThreadMs, Frame.RenderThreadMs, Frame.RHIThreadMs, Frame.GPUMs);
+		for (float TimingMs : Frame.TimingsMs)
+		{
+			Csv += FString::Printf(TEXT(",%.3f"), TimingMs);
+		}
+		Csv += LINE_TERMINATOR;
+	}
+
+	// Writing the file must not cause a hitch of its own.
+	FString Filename = FPaths::ProfilingDir() / TEXT("Hitches") / FString::Printf(TEXT("Hitch_%s_Frame%llu.csv"), *FDateTime::Now().ToString(), HitchFrameCounter);
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Csv = MoveTemp(Csv), Filename = MoveTemp(Filename), HitchFrameCounter]()
+	{
+		if (FFileHelper::SaveStringToFile(Csv, *Filename))
+		{
+			UE_LOG(LogEngine, Log, TEXT("Hitch recorder saved the frames around GT frame %llu to %s"), HitchFrameCounter, *Filename);
+		}
+	});
+}
+
+/** A pair of GPU timestamps around the passes of one FHitchRecorderGPUScope. */
+struct FGPUQuery
+{
+	FRHIPooledRenderQuery Begin;
+	FRHIPooledRenderQuery End;
+	EHitchRecorderTiming Timing = EHitchRecorderTiming::Num;
+
+	// 结束时间戳真正写进命令列表后才能读结果，池里复用的查询可能还留着旧结果
+	bool bSubmitted = false;
+};
+
+/** Timestamp queries of the GPU scopes, oldest first. Render thread. */
+class FHitchRecorderGPUQueries : public FRenderResource
+{
+public:
+	static constexpr int32 MaxPendingQueries = 64;
+
+	FGPUQuery* Allocate(EHitchRecorderTiming Timing)
+	{
+		ReadResults();
+		if (Queries.Num() >= MaxPendingQueries)
+		{
+			return nullptr;
+		}
+
+		if (!Pool.IsValid())
+		{
+			Pool = RHICreateRenderQueryPool(RQT_AbsoluteTime);
+		}
+
+		TUniquePtr<FGPUQuery>& Query = Queries.Add_GetRef(MakeUnique<FGPUQuery>());
+		Query->Begin = Pool->AllocateQuery();
+		Query->End = Pool->AllocateQuery();
+		Query->Timing = Timing;
+		return Query.Get();
+	}
+
+	void ReleaseRHI() override
+	{
+		Queries.Empty();
+		Pool.SafeRelease();
+	}
+
+private:
+	void ReadResults()
+	{
+		while (Queries.Num() > 0 && Queries[0]->bSubmitted)
+		{
+			uint64 BeginMicroseconds = 0;
+			uint64 EndMicroseconds = 0;
+			if (!RHIGetRenderQueryResult(Queries[0]->Begin.GetQuery(), BeginMicroseconds, false)
+				|| !RHIGetRenderQueryResult(Queries[0]->End.GetQuery(), EndMicroseconds, false))
+			{
+				break;
+			}
+
+			if (EndMicroseconds > BeginMicroseconds)
+			{
+				FHitchRecorder::Get().AddTime(Queries[0]->Timing, double(EndMicroseconds - BeginMicroseconds) / 1000000.0);
+			}
+			Queries.RemoveAt(0);
+		}
+	}
+
+	FRenderQueryPoolRHIRef Pool;
+	TArray<TUniquePtr<FGPUQuery>> Queries;
+};
+
+static TGlobalResource<FHitchRecorderGPUQueries> GHitchRecorderGPUQueries;
+
+FHitchRecorderGPUScope::FHitchRecorderGPUScope(FRDGBuilder& InGraphBuilder, EHitchRecorderTiming InTiming)
+	: GraphBuilder(InGraphBuilder)
+{
+	check(IsInRenderingThread());
+	if (!GHitchRecorderEnabled || !GSupportsTimestampRenderQueries)
+	{
+		return;
+	}
+
+	Query = GHitchRecorderGPUQueries.Allocate(InTiming);
+	if (Query)
+	{
+		GraphBuilder.AddPass(RDG_EVENT_NAME("HitchRecorderBegin"), ERDGPassFlags::NeverCull, [RenderQuery = Query->Begin.GetQuery()](FRHICommandListImmediate& RHICmdList)
+		{
+			RHICmdList.EndRenderQuery(RenderQuery);
+		});
+	}
+}
+
+FHitchRecorderGPUScope::~FHitchRecorderGPUScope()
+{
+	if (Query)
+	{
+		GraphBuilder.AddPass(RDG_EVENT_NAME("HitchRecorderEnd"), ERDGPassFlags::NeverCull, [Query = Query](FRHICommandListImmediate& RHICmdList)
+		{
+			RHICmdList.EndRenderQuery(Query->End.GetQuery());
+			Query->bSubmitted = true;
+		});
+	}
+}
@@ -109,6 +109,59 @@ bool IsAllowingApproximateOcclusionQueries()
 	return CVarApproximateOcclusionQueries.GetValueOnAnyThread() != 0;
 }
 
+//add Das 描边/关闭深度的自定义深度代理数量，这些绘制不能参与HZB遮挡剔除
+static std::atomic<int32> GNumDasCustomDepthOcclusionExempt(0);
+
+int32 FPrimitiveSceneProxy::GetNumDasCustomDepthOcclusionExempt()
+{
+	return GNumDasCustomDepthOcclusionExempt.load(std::memory_order_relaxed);
+}
+
+//add Das 半透明材质写自定义深度的代理数量，预pass可见性ID模式画不出它们
+static std::atomic<int32> GNumDasTranslucentCustomDepthWriters(0);
+
+int32 FPrimitiveSceneProxy::GetNumDasTranslucentCustomDepthWriters()
+{
+	return GNumDasTranslucentCustomDepthWriters.load(std::memory_order_relaxed);
+}
+
+//预pass可见性ID模式下Das值烘焙在缓存的深度pass绘制命令里，变化时只重建这个代理的缓存命令
+static bool IsDasPrePassVisibilityIdsEnabled()
+{
+	static const TConsoleVariableData<int32>* CVarDasPrePassVisibilityIds = IConsoleManager::Get().FindTConsoleVariableDataInt(TEXT("r.Das.PrePassVisibilityIds"));
+	return CVarDasPrePassVisibilityIds && CVarDasPrePassVisibilityIds->GetValueOnRenderThread() != 0;
+}
+
+//代理增删、移动、Das值和选中状态变化时递增，按需渲染据此判断场景是否变化
+static std::atomic<uint32> GSceneChangeRevision(0);
+
+uint32 FPrimitiveSceneProxy::GetSceneChangeRevision()
+{
+	return GSceneChangeRevision.load(std::memory_order_relaxed);
+}
+
+void FPrimitiveSceneProxy::NotifySceneChanged()
+{
+	GSceneChangeRevision.fetch_add(1, std::memory_order_relaxed);
+}
+
+//每帧都在动的代理(WPO动画、强制输出速度)，按需渲染只在它们可见时算场景变化，不用遍历所有可见图元
+static FCriticalSection GAlwaysAnimatedProxiesLock;
+static TSet<const FPrimitiveSceneProxy*> GAlwaysAnimatedProxies;
+
+bool FPrimitiveSceneProxy::AnyAlwaysAnimatedProxy(TFunctionRef<bool(const FPrimitiveSceneProxy&)> Predicate)
+{
+	FScopeLock Lock(&GAlwaysAnimatedProxiesLock);
+	for (const FPrimitiveSceneProxy* Proxy : GAlwaysAnimatedProxies)
+	{
+		if (Predicate(*Proxy))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 bool IsOptimizedWPO()
 {
 	return CVarOptimizedWPO.GetValueOnAnyThread() != 0;
@@ -501,6 +554,16 @@ FPrimitiveSceneProxy::FPrimitiveSceneProxy(const UPrimitiveComponent* InComponen
 				if (MaterialInterface->GetRelevance_Concurrent(FeatureLevel).bUsesWorldPositionOffset)
 				{
 					bAnyMaterialHasWorldPositionOffset = true;
+				}
+
+				//add Das
+				if (MaterialInterface->IsTranslucencyWritingCustomDepth())
+				{
+					bDasHasTranslucentCustomDepthMaterial = true;
+				}
+
+				if (bAnyMaterialHasWorldPositionOffset && bDasHasTranslucentCustomDepthMaterial)
+				{
 					break;
 				}
 			}
@@ -512,6 +575,22 @@ FPrimitiveSceneProxy::FPrimitiveSceneProxy(const UPrimitiveComponent* InComponen
 	{
 		bHasWorldPositionOffsetVelocity = true;
 	}
+
+	//add Das
+	if (IsDasCustomDepthOcclusionExempt())
+	{
+		++GNumDasCustomDepthOcclusionExempt;
+	}
+	if (IsDasTranslucentCustomDepthWriter())
+	{
+		++GNumDasTranslucentCustomDepthWriters;
+	}
+	if (bAlwaysHasVelocity || bHasWorldPositionOffsetVelocity)
+	{
+		FScopeLock Lock(&GAlwaysAnimatedProxiesLock);
+		GAlwaysAnimatedProxies.Add(this);
+	}
+	NotifySceneChanged();
 }
 
 bool FPrimitiveSceneProxy::OnLevelAddedToWorld_RenderThread()
@@ -539,6 +618,22 @@ void FPrimitiveSceneProxy::SetUsedMaterialForVerification(const TArray<UMaterial
 FPrimitiveSceneProxy::~FPrimitiveSceneProxy()
 {
 	check(IsInRenderingThread());
+
+	//add Das
+	if (IsDasCustomDepthOcclusionExempt())
+	{
+		--GNumDasCustomDepthOcclusionExempt;
+	}
+	if (IsDasTranslucentCustomDepthWriter())
+	{
+		--GNumDasTranslucentCustomDepthWriters;
+	}
+	if (bAlwaysHasVelocity || bHasWorldPositionOffsetVelocity)
+	{
+		FScopeLock Lock(&GAlwaysAnimatedProxiesLock);
+		GAlwaysAnimatedProxies.Remove(this);
+	}
+	NotifySceneChanged();
 }
 
 HHitProxy* FPrimitiveSceneProxy::CreateHitProxies(UPrimitiveComponent* Component,TArray<TRefCountPtr<HHitProxy> >& OutHitProxies)
@@ -773,6 +868,7 @@ uint32 FPrimitiveSceneProxy::GetPayloadDataStride() const
 void FPrimitiveSceneProxy::SetTransform(const FMatrix& InLocalToWorld, const FBoxSphereBounds& InBounds, const FBoxSphereBounds& InLocalBounds, FVector InActorPosition)
 {
 	check(IsInRenderingThread());
+	NotifySceneChanged();
 
 	// Update the cached transforms.
 	LocalToWorld = InLocalToWorld;
@@ -1058,6 +1154,7 @@ void FPrimitiveSceneProxy::SetSelection_RenderThread(const bool bInParentSelecte
 		(bIsSelected && !bWasSelected))
 	{
 		GetScene().UpdatePrimitiveSelectedState_RenderThread(GetPrimitiveSceneInfo(), bIsSelected);
+		NotifySceneChanged();
 	}
 }
 
@@ -1124,12 +1221,21 @@ void FPrimitiveSceneProxy::SetCustomDepthEnabled_RenderThread(const bool bInRend
 	check(IsInRenderingThread());
 	if (bRenderCustomDepth != bInRenderCustomDepth)
 	{
+		//add Das
+		const bool bWasTranslucentWriter = IsDasTranslucentCustomDepthWriter();
 		bRenderCustomDepth = bInRenderCustomDepth;
+		GNumDasTranslucentCustomDepthWriters += (int32)IsDasTranslucentCustomDepthWriter() - (int32)bWasTranslucentWriter;
 
 		if (PrimitiveSceneInfo)
 		{
 			Scene->RequestUniformBufferUpdate(*PrimitiveSceneInfo);
 
+			//add Das 可见性ID只给画自定义深度的物体写Das值
+			if (IsDasPrePassVisibilityIdsEnabled())
+			{
+				Scene->UpdateCachedRenderStates(this);
+			}
+
 			if (IsNaniteMesh())
 			{
 				// We have to invalidate the primitive scene info's Nanite raster bins to refresh
@@ -1212,19 +1318,39 @@ void FPrimitiveSceneProxy::SetCustomDepthStencilValue_RenderThread(const int32 I
 void FPrimitiveSceneProxy::SetDasStencilValue_RenderThread(const int32 value)
 {
 	check(IsInRenderingThread());
-	DasStencilValue = value;
+	if (DasStencilValue != value)
+	{
+		DasStencilValue = value;
+		if (PrimitiveSceneInfo && IsDasPrePassVisibilityIdsEnabled())
+		{
+			Scene->UpdateCachedRenderStates(this);
+		}
+	}
+	NotifySceneChanged();
 }
 
 void FPrimitiveSceneProxy::SetDasCustomValue_RenderThread(const int32 value)
 {
 	check(IsInRenderingThread());
+	const bool bWasExempt = IsDasCustomDepthOcclusionExempt();
+	const int32 PreviousValue = DasCustomValue;
 	DasCustomValue = value;
+	GNumDasCustomDepthOcclusionExempt += (int32)IsDasCustomDepthOcclusionExempt() - (int32)bWasExempt;
+	// 描边位不进可见性ID
+	if (((PreviousValue ^ value) & ~1) != 0 && PrimitiveSceneInfo && IsDasPrePassVisibilityIdsEnabled())
+	{
+		Scene->UpdateCachedRenderStates(this);
+	}
+	NotifySceneChanged();
 }
 
 void FPrimitiveSceneProxy::SetDasCustomAttribute_RenderThread(const TMap<FString, FString>& mapAttributes)
 {
 	check(IsInRenderingThread());
+	const bool bWasExempt = IsDasCustomDepthOcclusionExempt();
 	DasCustomAttributes = mapAttributes;
+	GNumDasCustomDepthOcclusionExempt += (int32)IsDasCustomDepthOcclusionExempt() - (int32)bWasExempt;
+	NotifySceneChanged();
 }
 
 
@@ -1248,7 +1374,11 @@ void FPrimitiveSceneProxy::GetPreSkinnedLocalBounds(FBoxSphereBounds& OutBounds)
 void FPrimitiveSceneProxy::SetHovered_RenderThread(const bool bInHovered)
 {
 	check(IsInRenderingThread());
-	bHovered = bInHovered;
+	if (bHovered != bInHovered)
+	{
+		bHovered = bInHovered;
+		NotifySceneChanged();
+	}
 }
 
 /**
@@ -0,0 +1,186 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "StartupTimeline.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/PackageName.h"
+#include "UObject/UObjectGlobals.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Rendering/SlateRenderer.h"
+#include "EngineLogs.h"
+
+UE_TRACE_CHANNEL_DEFINE(StartupChannel);
+
+static bool GStartupTimelineSaveReport = true;
+static FAutoConsoleVariableRef CVarStartupTimelineSaveReport(
+	TEXT("t.StartupTimeline.SaveReport"),
+	GStartupTimelineSaveReport,
+	TEXT("If true, the startup timeline is saved to Saved/Profiling/Startup as CSV once the first frame has been presented. It is always logged."),
+	ECVF_Default
+	);
+
+FStartupTimeline& FStartupTimeline::Get()
+{
+	static FStartupTimeline Timeline;
+	return Timeline;
+}
+
+FStartupTimeline::FStartupTimeline()
+	: FirstFramePresentedTime(0.0)
+{
+	// 启动时的地图加载，StartGameInstance里同步完成
+	PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddLambda([this](const FString& MapName)
+	{
+		if (LoadMapPhaseIndex == INDEX_NONE)
+		{
+			LoadMapPhaseIndex = BeginPhase(*FString::Printf(TEXT("LoadMap %s"), *FPackageName::GetShortName(MapName)));
+		}
+	});
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddLambda([this](UWorld*)
+	{
+		EndPhase(LoadMapPhaseIndex);
+		LoadMapPhaseIndex = INDEX_NONE;
+	});
+}
+
+int32 FStartupTimeline::BeginPhase(const TCHAR* Name)
+{
+	if (bReported)
+	{
+		return INDEX_NONE;
+	}
+
+	FPhase& Phase = Phases.AddDefaulted_GetRef();
+	Phase.Name = Name;
+	Phase.StartTime = FPlatformTime::Seconds();
+	Phase.Depth = OpenPhaseCount++;
+	return Phases.Num() - 1;
+}
+
+void FStartupTimeline::EndPhase(int32 PhaseIndex)
+{
+	if (Phases.IsValidIndex(PhaseIndex) && Phases[PhaseIndex].EndTime == 0.0)
+	{
+		Phases[PhaseIndex].EndTime = FPlatformTime::Seconds();
+		--OpenPhaseCount;
+	}
+}
+
+void FStartupTimeline::WaitForFirstPresent(const TSharedRef<SWindow>& GameWindow)
+{
+	if (bReported || BackBufferReadyHandle.IsValid() || !FSlateApplication::IsInitialized() || !FSlateApplication::Get().GetRenderer())
+	{
+		return;
+	}
+
+	bWaitForFirstPresent = true;
+	PresentWindow = &GameWindow.Get();
+	// 编辑器和其他窗口也会提交back buffer，只认游戏窗口
+	BackBufferReadyHandle = FSlateApplication::Get().GetRenderer()->OnBackBufferReadyToPresent().AddLambda([this](SWindow& Window, const FTextureRHIRef&)
+	{
+		if (&Window == PresentWindow)
+		{
+			MarkFirstFramePresented();
+		}
+	});
+}
+
+void FStartupTimeline::MarkFirstFrameRendered()
+{
+	if (FirstFrameRenderedTime == 0.0)
+	{
+		FirstFrameRenderedTime = FPlatformTime::Seconds();
+	}
+}
+
+void FStartupTimeline::MarkFirstFramePresented()
+{
+	double Expected = 0.0;
+	FirstFramePresentedTime.compare_exchange_strong(Expected, FPlatformTime::Seconds());
+}
+
+void FStartupTimeline::Tick()
+{
+	if (bReported || FirstFrameRenderedTime == 0.0)
+	{
+		return;
+	}
+
+	if (bWaitForFirstPresent && FirstFramePresentedTime.load() == 0.0)
+	{
+		return;
+	}
+
+	Report();
+}
+
+void FStartupTimeline::Report()
+{
+	bReported = true;
+	FCoreUObjectDelegates::PreLoadMap.Remove(PreLoadMapHandle);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	if (BackBufferReadyHandle.IsValid() && FSlateApplication::IsInitialized() && FSlateApplication::Get().GetRenderer())
+	{
+		FSlateApplication::Get().GetRenderer()->OnBackBufferReadyToPresent().Remove(BackBufferReadyHandle);
+	}
+	BackBufferReadyHandle.Reset();
+	PresentWindow = nullptr;
+
+	const double PresentedTime = FirstFramePresentedTime.load();
+	const double EndTime = PresentedTime != 0.0 ? PresentedTime : FirstFrameRenderedTime;
+	TRACE_BOOKMARK(TEXT("Startup complete"));
+
+	// GStartTime到第一个阶段之间是引擎PreInit，模块加载在这里
+	TArray<FPhase> ReportPhases;
+	if (Phases.Num() > 0 && Phases[0].StartTime > GStartTime)
+	{
+		FPhase& PreInit = ReportPhases.AddDefaulted_GetRef();
+		PreInit.Name = TEXT("EnginePreInit");
+		PreInit.StartTime = GStartTime;
+		PreInit.EndTime = Phases[0].StartTime;
+	}
+	ReportPhases.Append(Phases);
+
+	double LastPhaseEndTime = 0.0;
+	for (const FPhase& Phase : Phases)
+	{
+		LastPhaseEndTime = FMath::Max(LastPhaseEndTime, Phase.EndTime);
+	}
+	if (LastPhaseEndTime != 0.0 && FirstFrameRenderedTime > LastPhaseEndTime)
+	{
+		FPhase& FirstFrame = ReportPhases.AddDefaulted_GetRef();
+		FirstFrame.Name = TEXT("FirstFrameRendered");
+		FirstFrame.StartTime = LastPhaseEndTime;
+		FirstFrame.EndTime = FirstFrameRenderedTime;
+	}
+	if (PresentedTime > FirstFrameRenderedTime)
+	{
+		FPhase& FirstPresent = ReportPhases.AddDefaulted_GetRef();
+		FirstPresent.Name = TEXT("FirstFramePresented");
+		FirstPresent.StartTime = FirstFrameRenderedTime;
+		FirstPresent.EndTime = PresentedTime;
+	}
+
+	UE_LOG(LogInit, Display, TEXT("Startup timeline, %.3f s from process start to the first %s frame:"), EndTime - GStartTime, PresentedTime != 0.0 ? TEXT("presented") : TEXT("rendered"));
+
+	FString Csv = TEXT("Phase,Depth,StartMs,DurationMs\n");
+	for (const FPhase& Phase : ReportPhases)
+	{
+		// 没有结束的阶段算到报告时刻
+		const double PhaseEndTime = Phase.EndTime != 0.0 ? Phase.EndTime : EndTime;
+		const double StartMs = (Phase.StartTime - GStartTime) * 1000.0;
+		const double DurationMs = (PhaseEndTime - Phase.StartTime) * 1000.0;
+
+		UE_LOG(LogInit, Display, TEXT("  %s%-*s %10.2f ms  (at %.2f ms)"), *FString::ChrN(Phase.Depth * 2, TEXT(' ')), 40 - Phase.Depth * 2, *Phase.Name, DurationMs, StartMs);
+		Csv += FString::Printf(TEXT("%s,%d,%.3f,%.3f\n"), *Phase.Name, Phase.Depth, StartMs, DurationMs);
+	}
+
+	if (GStartupTimelineSaveReport)
+	{
+		const FString Filename = FPaths::ProfilingDir() / TEXT("Startup") / FString::Printf(TEXT("Startup_%s.csv"), *FDateTime::Now().ToString());
+		FFileHelper::SaveStringToFile(Csv, *Filename);
+	}
+
+	Phases.Empty();
+}
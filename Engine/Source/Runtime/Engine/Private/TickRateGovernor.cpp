@@ -0,0 +1,175 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "TickRateGovernor.h"
+#include "Framework/Application/SlateApplication.h"
+#include "HAL/IConsoleManager.h"
+
+static bool GTickRateGovernor = false;
+static FAutoConsoleVariableRef CVarTickRateGovernor(
+	TEXT("t.TickRateGovernor"),
+	GTickRateGovernor,
+	TEXT("If true, the max tick rate follows input activity, viewer count and encoder back-pressure (see t.TickRateGovernor.*)."),
+	ECVF_Default
+	);
+
+static float GTickRateGovernorActiveRate = 60.0f;
+static FAutoConsoleVariableRef CVarTickRateGovernorActiveRate(
+	TEXT("t.TickRateGovernor.ActiveRate"),
+	GTickRateGovernorActiveRate,
+	TEXT("Max tick rate while the user is interacting."),
+	ECVF_Default
+	);
+
+static float GTickRateGovernorIdleRate = 5.0f;
+static FAutoConsoleVariableRef CVarTickRateGovernorIdleRate(
+	TEXT("t.TickRateGovernor.IdleRate"),
+	GTickRateGovernorIdleRate,
+	TEXT("Max tick rate once there was no input for t.TickRateGovernor.IdleDelay seconds. Also the lowest rate back-pressure can push to."),
+	ECVF_Default
+	);
+
+static float GTickRateGovernorIdleDelay = 2.0f;
+static FAutoConsoleVariableRef CVarTickRateGovernorIdleDelay(
+	TEXT("t.TickRateGovernor.IdleDelay"),
+	GTickRateGovernorIdleDelay,
+	TEXT("Seconds without input before the tick rate drops to t.TickRateGovernor.IdleRate."),
+	ECVF_Default
+	);
+
+static float GTickRateGovernorNoViewerRate = 1.0f;
+static FAutoConsoleVariableRef CVarTickRateGovernorNoViewerRate(
+	TEXT("t.TickRateGovernor.NoViewerRate"),
+	GTickRateGovernorNoViewerRate,
+	TEXT("Max tick rate while a streamer reports no connected viewers."),
+	ECVF_Default
+	);
+
+static FAutoConsoleCommand CmdTickRateGovernorDump(
+	TEXT("t.TickRateGovernor.Dump"),
+	TEXT("Prints the max tick rate proposed by every tick rate governor policy."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar) { FTickRateGovernor::Get().Dump(Ar); })
+	);
+
+/** Full rate while the user interacts, idle rate after a short quiet period. */
+class FInputActivityTickRatePolicy : public ITickRateGovernorPolicy
+{
+public:
+	virtual float GetMaxTickRate() const override
+	{
+		if (!FSlateApplication::IsInitialized())
+		{
+			return 0.0f;
+		}
+
+		const double SecondsSinceInput = FPlatformTime::Seconds() - FSlateApplication::Get().GetLastUserInteractionTime();
+		return SecondsSinceInput < GTickRateGovernorIdleDelay ? GTickRateGovernorActiveRate : GTickRateGovernorIdleRate;
+	}
+
+	virtual const TCHAR* GetName() const override { return TEXT("InputActivity"); }
+};
+
+/** Nearly stops ticking when a streamer reports that nobody is watching. */
+class FViewerCountTickRatePolicy : public ITickRateGovernorPolicy
+{
+public:
+	virtual float GetMaxTickRate() const override
+	{
+		return FTickRateGovernor::Get().GetViewerCount() == 0 ? GTickRateGovernorNoViewerRate : 0.0f;
+	}
+
+	virtual const TCHAR* GetName() const override { return TEXT("ViewerCount"); }
+};
+
+/** Scales the active rate down with encoder congestion so frames are not produced only to be dropped. */
+class FBackPressureTickRatePolicy : public ITickRateGovernorPolicy
+{
+public:
+	virtual float GetMaxTickRate() const override
+	{
+		const float BackPressure = FTickRateGovernor::Get().GetBackPressure();
+		if (BackPressure <= 0.0f)
+		{
+			return 0.0f;
+		}
+
+		return FMath::Max(GTickRateGovernorActiveRate * (1.0f - BackPressure), GTickRateGovernorIdleRate);
+	}
+
+	virtual const TCHAR* GetName() const override { return TEXT("BackPressure"); }
+};
+
+FTickRateGovernor::FTickRateGovernor()
+{
+	Policies.Add(MakeShared<FInputActivityTickRatePolicy>());
+	Policies.Add(MakeShared<FViewerCountTickRatePolicy>());
+	Policies.Add(MakeShared<FBackPressureTickRatePolicy>());
+}
+
+FTickRateGovernor& FTickRateGovernor::Get()
+{
+	static FTickRateGovernor Governor;
+	return Governor;
+}
+
+bool FTickRateGovernor::IsEnabled()
+{
+	return GTickRateGovernor;
+}
+
+void FTickRateGovernor::RegisterPolicy(TSharedRef<ITickRateGovernorPolicy> Policy)
+{
+	check(IsInGameThread());
+	Policies.AddUnique(Policy);
+}
+
+void FTickRateGovernor::UnregisterPolicy(TSharedRef<ITickRateGovernorPolicy> Policy)
+{
+	check(IsInGameThread());
+	Policies.Remove(Policy);
+}
+
+void FTickRateGovernor::SetViewerCount(int32 InViewerCount)
+{
+	ViewerCount = InViewerCount;
+}
+
+void FTickRateGovernor::SetBackPressure(float InBackPressure)
+{
+	BackPressure = FMath::Clamp(InBackPressure, 0.0f, 1.0f);
+}
+
+void FTickRateGovernor::Dump(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("TickRateGovernor %s, viewers %d, back-pressure %.2f"),
+		IsEnabled() ? TEXT("on") : TEXT("off"),
+		GetViewerCount(),
+		GetBackPressure());
+
+	for (const TSharedRef<ITickRateGovernorPolicy>& Policy : Policies)
+	{
+		const float PolicyTickRate = Policy->GetMaxTickRate();
+		if (PolicyTickRate > 0.0f)
+		{
+			Ar.Logf(TEXT("  %-20s %.1f"), Policy->GetName(), PolicyTickRate);
+		}
+		else
+		{
+			Ar.Logf(TEXT("  %-20s no limit"), Policy->GetName());
+		}
+	}
+
+	Ar.Logf(TEXT("  result %.1f"), Apply(0.0f));
+}
+
+float FTickRateGovernor::Apply(float MaxTickRate) const
+{
+	for (const TSharedRef<ITickRateGovernorPolicy>& Policy : Policies)
+	{
+		const float PolicyTickRate = Policy->GetMaxTickRate();
+		if (PolicyTickRate > 0.0f)
+		{
+			MaxTickRate = MaxTickRate > 0.0f ? FMath::Min(MaxTickRate, PolicyTickRate) : PolicyTickRate;
+		}
+	}
+	return MaxTickRate;
+}
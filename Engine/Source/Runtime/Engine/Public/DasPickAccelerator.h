@@ -0,0 +1,106 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UPrimitiveComponent;
+class UStaticMesh;
+class UWorld;
+struct FConvexVolume;
+struct FDasPickMeshBVH;
+
+/** Result of a CPU pick. */
+struct FDasPickHit
+{
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	int32 DasStencilValue = 0;
+
+	/** Same value the depth pass writes: UV channel 7 (x * 1024 + y), or per-instance custom data 0 for instanced meshes. */
+	int32 BatchID = 0;
+	int32 InstanceIndex = INDEX_NONE;
+
+	FVector Location = FVector::ZeroVector;
+	FVector Normal = FVector::ZeroVector;
+	double Distance = 0.0;
+
+	/** False when only the component bounds were hit, because the mesh has no CPU data (r.Das.CpuPick.BoundsFallback). */
+	bool bTriangleHit = false;
+
+	/** The value the depth pass writes into DasStencil for this hit, e.g. for SetDasHoveredId. */
+	uint32 GetDasStencilId() const { return (uint32)(DasStencilValue + BatchID); }
+};
+
+/**
+ * Render independent picking for components in the Das ID path (render custom depth or a non-zero DasStencilValue), without
+ * physics and without waiting for a DasStencil readback. Pickability only depends on registration, visibility and Das relevance,
+ * so it also works on dedicated servers and under -nullrhi where no scene proxies exist. Registered components sit in a dynamic AABB tree over their world
+ * bounds, which is updated incrementally as render state is created or transforms are sent; static meshes get a triangle
+ * BVH built on first pick from the CPU copy of LOD0.
+ *
+ * Cooked builds only keep that copy for meshes with bAllowCPUAccess, other meshes fall back to their bounds. Queries are game
+ * thread only, notifications may come from any thread.
+ */
+class FDasPickAccelerator
+{
+public:
+	static ENGINE_API FDasPickAccelerator& Get();
+
+	/** Queues a component whose bounds or pick relevance may have changed. Any thread. */
+	static ENGINE_API void NotifyPrimitiveChanged(const UPrimitiveComponent* Component);
+
+	/** Closest hit along the segment. Returns false if nothing was hit. */
+	ENGINE_API bool RayPick(const UWorld* World, const FVector& Start, const FVector& End, FDasPickHit& OutHit);
+
+	/** Every component, instance and batch ID with geometry overlapping the frustum, e.g. for a marquee selection. Triangles are tested by their bounds. */
+	ENGINE_API void FrustumPick(const UWorld* World, const FConvexVolume& Frustum, TArray<FDasPickHit>& OutHits);
+
+	/** Drops every indexed component and cached mesh BVH. */
+	ENGINE_API void Reset();
+
+private:
+	FDasPickAccelerator();
+
+	struct FNode
+	{
+		FBox Box;
+		int32 Parent = INDEX_NONE;
+		int32 Children[2] = { INDEX_NONE, INDEX_NONE };
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		FObjectKey ComponentKey;
+		FObjectKey World;
+
+		bool IsLeaf() const { return Children[0] == INDEX_NONE; }
+	};
+
+	void FlushPendingChanges();
+	bool IsPickable(const UPrimitiveComponent* Component, const UWorld* World) const;
+
+	int32 AllocateNode();
+	void FreeNode(int32 NodeIndex);
+	void InsertLeaf(int32 Leaf);
+	void RemoveLeaf(int32 Leaf);
+	void RemoveComponent(FObjectKey ComponentKey);
+	void UpdateComponent(UPrimitiveComponent* Component);
+
+	TSharedPtr<const FDasPickMeshBVH> FindOrBuildMeshBVH(UStaticMesh* StaticMesh);
+	bool PickComponent(UPrimitiveComponent* Component, const FVector& Start, const FVector& End, double& InOutBestTime, FDasPickHit& OutHit);
+	void FrustumPickComponent(UPrimitiveComponent* Component, const FConvexVolume& Frustum, TArray<FDasPickHit>& OutHits);
+
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+	void OnPostGarbageCollect();
+
+	TArray<FNode> Nodes;
+	int32 Root = INDEX_NONE;
+	int32 FreeList = INDEX_NONE;
+	TMap<FObjectKey, int32> Leaves;
+
+	TMap<FObjectKey, TSharedPtr<const FDasPickMeshBVH>> MeshBVHs;
+
+	FCriticalSection PendingCriticalSection;
+	TSet<FObjectKey> PendingComponents;
+
+	bool bDelegatesRegistered = false;
+};
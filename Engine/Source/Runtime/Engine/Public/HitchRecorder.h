@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FRDGBuilder;
+
+/** Per-frame timings kept by the hitch recorder on top of the thread and GPU frame times. */
+enum class EHitchRecorderTiming : uint8
+{
+	/** Render thread setup of the pass. */
+	PrePass,
+	BasePass,
+	CustomDepth,
+	/** GPU execution of the pass. */
+	PrePassGPU,
+	BasePassGPU,
+	CustomDepthGPU,
+	GarbageCollection,
+	Streaming,
+	Num
+};
+
+/**
+ * Always-on ring buffer of per-frame timings. When a frame exceeds t.SlowFrameLoggingThreshold, the frames around it are
+ * written to Saved/Profiling/Hitches as CSV, so hitches reported from the field come with data without running Insights.
+ * Render pass setup timings belong to the previous game thread frame. GPU pass timings come from timestamp queries read back
+ * without waiting, so they land in a frame recorded a few frames after the one that drew them.
+ */
+class FHitchRecorder
+{
+public:
+	static ENGINE_API FHitchRecorder& Get();
+
+	/** Adds time to the frame being recorded. Any thread. */
+	ENGINE_API void AddTime(EHitchRecorderTiming Timing, double Seconds);
+
+	/** Closes the frame being recorded and dumps the window around a hitch once enough frames followed it. Game thread. */
+	ENGINE_API void EndFrame(float DeltaSeconds, float HitchThresholdSeconds);
+
+	/** Returns a timing of the most recently closed frame, 0 while t.HitchRecorder is off. Game thread. */
+	ENGINE_API float GetLastFrameTimeMs(EHitchRecorderTiming Timing) const;
+
+private:
+	FHitchRecorder();
+
+	struct FFrame
+	{
+		uint64 FrameCounter = 0;
+		float DeltaMs = 0.0f;
+		float GameThreadMs = 0.0f;
+		float RenderThreadMs = 0.0f;
+		float RHIThreadMs = 0.0f;
+		float GPUMs = 0.0f;
+		float TimingsMs[(int32)EHitchRecorderTiming::Num] = {};
+	};
+
+	void Dump(uint64 HitchFrameCounter) const;
+
+	TArray<FFrame> Frames;
+	int32 Capacity = 0;
+	int32 NextFrameIndex = 0;
+	std::atomic<int64> PendingTimingsMicroseconds[(int32)EHitchRecorderTiming::Num];
+
+	uint64 PendingHitchFrameCounter = 0;
+	int32 FramesUntilDump = 0;
+	double LastDumpTime = -DBL_MAX;
+	double GarbageCollectStartTime = 0.0;
+};
+
+/** Adds the time spent in the enclosing scope to a hitch recorder timing. */
+class FHitchRecorderScope
+{
+public:
+	explicit FHitchRecorderScope(EHitchRecorderTiming InTiming)
+		: Timing(InTiming)
+		, StartTime(FPlatformTime::Seconds())
+	{
+	}
+
+	~FHitchRecorderScope()
+	{
+		FHitchRecorder::Get().AddTime(Timing, FPlatformTime::Seconds() - StartTime);
+	}
+
+private:
+	EHitchRecorderTiming Timing;
+	double StartTime;
+};
+
+/** Adds the GPU time of the RDG passes added in the enclosing scope to a hitch recorder timing. Render thread. */
+class FHitchRecorderGPUScope
+{
+public:
+	ENGINE_API FHitchRecorderGPUScope(FRDGBuilder& InGraphBuilder, EHitchRecorderTiming InTiming);
+	ENGINE_API ~FHitchRecorderGPUScope();
+
+private:
+	FRDGBuilder& GraphBuilder;
+	struct FGPUQuery* Query = nullptr;
+};
@@ -658,6 +658,19 @@ public:
 	inline int32 GetDasStencilValue() const { return DasStencilValue; }
 	inline int32 GetDasCustomValue() const { return DasCustomValue; }
 	inline const TMap<FString, FString>& GetDasCustomAttributes() const {return DasCustomAttributes;}
+	//描边(DasCustom第一位)或关闭深度的自定义深度绘制，不参与HZB遮挡剔除
+	inline bool IsDasCustomDepthOcclusionExempt() const { return (DasCustomValue & 1) != 0 || DasCustomAttributes.Contains(TEXT("EnableDepthOffOnCustom")); }
+	//当前存活的需要豁免遮挡剔除的代理数量
+	static ENGINE_API int32 GetNumDasCustomDepthOcclusionExempt();
+	//当前存活的半透明材质写自定义深度的代理数量
+	static ENGINE_API int32 GetNumDasTranslucentCustomDepthWriters();
+	inline bool IsDasTranslucentCustomDepthWriter() const { return bRenderCustomDepth && bDasHasTranslucentCustomDepthMaterial; }
+	//场景变化计数，按需渲染(r.RenderOnDemand)比较前后两次的值决定是否重绘
+	static ENGINE_API uint32 GetSceneChangeRevision();
+	//代理之外的变化(材质参数、骨骼姿势等)也需要重绘时调用，任意线程
+	static ENGINE_API void NotifySceneChanged();
+	//对每帧都在动的代理(WPO动画、强制输出速度)调用Predicate，有一个返回true即返回true
+	static ENGINE_API bool AnyAlwaysAnimatedProxy(TFunctionRef<bool(const FPrimitiveSceneProxy&)> Predicate);
 
 	inline EStencilMask GetStencilWriteMask() const { return CustomDepthStencilWriteMask; }
 	inline uint8 GetLightingChannelMask() const { return LightingChannelMask; }
@@ -1483,6 +1496,8 @@ private:
 
 	TMap<FString, FString> DasCustomAttributes;//addDas use by: 1.material DephtTest;
 
+	bool bDasHasTranslucentCustomDepthMaterial = false;//addDas translucent material writing custom depth
+
 	/** When writing custom depth stencil, use this write mask */
 	TEnumAsByte<EStencilMask> CustomDepthStencilWriteMask;
 
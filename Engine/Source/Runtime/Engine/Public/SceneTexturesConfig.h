@@ -36,6 +36,7 @@ BEGIN_GLOBAL_SHADER_PARAMETER_STRUCT(FSceneTextureUniformParameters, ENGINE_API)
 	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DasStencilTexture)
 	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DasCustomTexture)
 	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DasCustomDepthOnTexture)
+	SHADER_PARAMETER(uint32, DasHoveredId)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D<uint2>, CustomStencilTexture)
 
 	// Misc
@@ -52,6 +53,16 @@ BEGIN_GLOBAL_SHADER_PARAMETER_STRUCT(FMobileSceneTextureUniformParameters, ENGIN
 	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, CustomDepthTexture)
 	SHADER_PARAMETER_SAMPLER(SamplerState, CustomDepthTextureSampler)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D<uint2>, CustomStencilTexture)
+	//add das
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DasDepthTexture)
+	SHADER_PARAMETER_SAMPLER(SamplerState, DasDepthTextureSampler)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DasStencilTexture)
+	SHADER_PARAMETER_SAMPLER(SamplerState, DasStencilTextureSampler)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DasCustomTexture)
+	SHADER_PARAMETER_SAMPLER(SamplerState, DasCustomTextureSampler)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DasCustomDepthOnTexture)
+	SHADER_PARAMETER_SAMPLER(SamplerState, DasCustomDepthOnTextureSampler)
+	SHADER_PARAMETER(uint32, DasHoveredId)
 	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SceneVelocityTexture)
 	SHADER_PARAMETER_SAMPLER(SamplerState, SceneVelocityTextureSampler)
 	// GBuffer
@@ -129,6 +140,7 @@ struct FSceneTexturesConfig
 		, bPreciseDepthAux{}
 		, bSamplesCustomStencil{}
 		, bMemorylessMSAA{}
+		, bMemorylessCustomDepth{}
 		, bSupportsXRTargetManagerDepthAlloc{}
 	{}
 
@@ -202,6 +214,9 @@ struct FSceneTexturesConfig
 	// (Mobile) True if MSAA targets can be memoryless
 	uint32 bMemorylessMSAA : 1;
 
+	// (Mobile) True if the custom depth-stencil target is only used inside the custom depth pass (Das outputs only) and can stay in tile memory
+	uint32 bMemorylessCustomDepth : 1;
+
 	// (XR) True if we can request an XR depth swapchain
 	uint32 bSupportsXRTargetManagerDepthAlloc : 1;
     
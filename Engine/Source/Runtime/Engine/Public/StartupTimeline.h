@@ -0,0 +1,93 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/** Startup phases are also emitted as CPU events on this channel, enable it with -trace=startup. */
+UE_TRACE_CHANNEL_EXTERN(StartupChannel, ENGINE_API);
+
+class SWindow;
+
+/**
+ * Per-phase durations of a cold start, from process start to the first presented frame of the game window.
+ * Once the first frame is presented the timeline is logged as one report and saved to Saved/Profiling/Startup.
+ * Phases nest, the report indents a phase under the phase that was open when it began. Game thread only,
+ * except MarkFirstFramePresented.
+ */
+class FStartupTimeline
+{
+public:
+	static ENGINE_API FStartupTimeline& Get();
+
+	/** Opens a phase and returns its index for EndPhase, INDEX_NONE once the report has been emitted. */
+	ENGINE_API int32 BeginPhase(const TCHAR* Name);
+	ENGINE_API void EndPhase(int32 PhaseIndex);
+
+	/**
+	 * Call once the game window has a presentation target, until then the first rendered frame completes the timeline.
+	 * Listens for the window's back buffers on the Slate renderer until the report is emitted.
+	 */
+	ENGINE_API void WaitForFirstPresent(const TSharedRef<SWindow>& GameWindow);
+
+	/** Game thread, after the first frame has been submitted for rendering. */
+	ENGINE_API void MarkFirstFrameRendered();
+
+	/** Any thread, when the first back buffer of the game window is about to be presented. Called by WaitForFirstPresent's listener. */
+	ENGINE_API void MarkFirstFramePresented();
+
+	/** Emits the report once the first frame has been presented. Game thread. */
+	ENGINE_API void Tick();
+
+	bool IsComplete() const { return bReported; }
+
+private:
+	FStartupTimeline();
+
+	struct FPhase
+	{
+		FString Name;
+		double StartTime = 0.0;
+		double EndTime = 0.0;
+		int32 Depth = 0;
+	};
+
+	void Report();
+
+	TArray<FPhase> Phases;
+	int32 OpenPhaseCount = 0;
+	double FirstFrameRenderedTime = 0.0;
+	std::atomic<double> FirstFramePresentedTime;
+	bool bWaitForFirstPresent = false;
+	bool bReported = false;
+	FDelegateHandle PreLoadMapHandle;
+	FDelegateHandle PostLoadMapHandle;
+	FDelegateHandle BackBufferReadyHandle;
+	// 渲染线程只比较地址，不解引用
+	const SWindow* PresentWindow = nullptr;
+	int32 LoadMapPhaseIndex = INDEX_NONE;
+};
+
+/** Times the enclosing scope as a startup phase. */
+class FStartupTimelineScope
+{
+public:
+	explicit FStartupTimelineScope(const TCHAR* Name)
+		: PhaseIndex(FStartupTimeline::Get().BeginPhase(Name))
+	{
+	}
+
+	~FStartupTimelineScope()
+	{
+		FStartupTimeline::Get().EndPhase(PhaseIndex);
+	}
+
+private:
+	int32 PhaseIndex;
+};
+
+#define SCOPED_STARTUP_TIMELINE(Name) \
+	FStartupTimelineScope PREPROCESSOR_JOIN(StartupTimelineScope, __LINE__)(TEXT(Name)); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(Name, StartupChannel)
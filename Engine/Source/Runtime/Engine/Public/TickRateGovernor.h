@@ -0,0 +1,56 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** A rule that limits the engine tick rate, e.g. from user activity or from streaming back-pressure. */
+class ITickRateGovernorPolicy
+{
+public:
+	virtual ~ITickRateGovernorPolicy() = default;
+
+	/** Returns the max tick rate this policy allows right now, or 0 if it has no opinion. Game thread. */
+	virtual float GetMaxTickRate() const = 0;
+
+	/** Name printed by t.TickRateGovernor.Dump. */
+	virtual const TCHAR* GetName() const = 0;
+};
+
+/**
+ * Adjusts UGameEngine::GetMaxTickRate at runtime when t.TickRateGovernor is on. Every registered policy proposes a rate
+ * and the lowest one wins. Built-in policies raise the rate during input activity and lower it when idle, when nobody
+ * is watching and when the encoder reports congestion. Streaming plugins feed the latter two through
+ * SetViewerCount and SetBackPressure, e.g. Pixel Streaming from its connections and send statistics.
+ */
+class FTickRateGovernor
+{
+public:
+	static ENGINE_API FTickRateGovernor& Get();
+
+	ENGINE_API void RegisterPolicy(TSharedRef<ITickRateGovernorPolicy> Policy);
+	ENGINE_API void UnregisterPolicy(TSharedRef<ITickRateGovernorPolicy> Policy);
+
+	/** Returns MaxTickRate limited by the registered policies. 0 means unlimited, as in GetMaxTickRate. */
+	ENGINE_API float Apply(float MaxTickRate) const;
+
+	/** Number of remote viewers, INDEX_NONE while no streamer reports it. */
+	ENGINE_API void SetViewerCount(int32 InViewerCount);
+	int32 GetViewerCount() const { return ViewerCount; }
+
+	/** Encoder congestion from 0 (none) to 1 (saturated), e.g. the share of captured frames the stream did not send. */
+	ENGINE_API void SetBackPressure(float InBackPressure);
+	float GetBackPressure() const { return BackPressure; }
+
+	static ENGINE_API bool IsEnabled();
+
+	/** Prints the inputs, every policy's proposed rate and the result. Game thread. */
+	ENGINE_API void Dump(FOutputDevice& Ar) const;
+
+private:
+	FTickRateGovernor();
+
+	TArray<TSharedRef<ITickRateGovernorPolicy>> Policies;
+	std::atomic<int32> ViewerCount{ INDEX_NONE };
+	std::atomic<float> BackPressure{ 0.0f };
+};
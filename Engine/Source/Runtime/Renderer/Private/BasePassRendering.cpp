@@ -26,6 +26,7 @@
 #include "DataDrivenShaderPlatformInfo.h"
 #include "VolumetricFog.h"
 #include "PostProcess/SceneRenderTargets.h"
+#include "HitchRecorder.h"
 
 #include "BasePassRendering.inl"
 
@@ -963,6 +964,8 @@ void FDeferredShadingSceneRenderer::RenderBasePass(
 	const TArrayView<Nanite::FRasterResults>& NaniteRasterResults)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(FDeferredShadingSceneRenderer::RenderBasePass);
+	FHitchRecorderScope HitchRecorderScope(EHitchRecorderTiming::BasePass);
+	FHitchRecorderGPUScope HitchRecorderGPUScope(GraphBuilder, EHitchRecorderTiming::BasePassGPU);
 
 	const bool bEnableParallelBasePasses = GRHICommandList.UseParallelAlgorithms() && CVarParallelBasePass.GetValueOnRenderThread();
 
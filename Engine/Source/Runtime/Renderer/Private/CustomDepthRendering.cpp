@@ -12,6 +12,8 @@
 #include "UnrealEngine.h"
 #include "DasConfig.h"
 #include "BasePassRendering.h"
+#include "RenderGraphUtils.h"
+#include "HitchRecorder.h"
 
 static TAutoConsoleVariable<int32> CVarCustomDepth(
 	TEXT("r.CustomDepth"),
@@ -42,12 +44,23 @@ static TAutoConsoleVariable<bool> CVarCustomDepthEnableFastClear(
 	TEXT("Enable HTile on the custom depth buffer (default:false).\n"),
 	ECVF_RenderThreadSafe);
 
+//add Das 自定义深度使用主视图HZB做实例遮挡剔除
+static TAutoConsoleVariable<int32> CVarDasCustomDepthOcclusionCull(
+	TEXT("r.Das.CustomDepth.OcclusionCull"),
+	0,
+	TEXT("Whether CustomDepth instances are culled against the main view HZB through GPU instance culling.\n")
+	TEXT(" 0: Off, every custom depth primitive that passed frustum culling is drawn [default]\n")
+	TEXT(" 1: On, uses the previous frame HZB (requires r.InstanceCulling.OcclusionCull). Disabled while any outline or depth-off custom depth primitive exists."),
+	ECVF_RenderThreadSafe);
+
 DECLARE_DWORD_COUNTER_STAT(TEXT("Nanite Custom Depth Instances"), STAT_NaniteCustomDepthInstances, STATGROUP_Nanite);
 
 DECLARE_GPU_DRAWCALL_STAT_NAMED(CustomDepth, TEXT("Custom Depth"));
 
 using FNaniteCustomDepthDrawList = TArray<Nanite::FInstanceDraw, SceneRenderingAllocator>;
 
+RDG_REGISTER_BLACKBOARD_STRUCT(FDasVisibilityIdTextures);
+
 ECustomDepthPassLocation GetCustomDepthPassLocation(EShaderPlatform Platform)
 {
 	const int32 CustomDepthOrder = CVarCustomDepthOrder.GetValueOnRenderThread();
@@ -77,12 +90,61 @@ void SetDasCustomRenderModel(DasCustomRenderModel nmodel)
 	snDasCusotmModel = nmodel;
 }
 
+static std::atomic<int32> snDasCustomDepthConsumers(0);
+static std::atomic<bool> sbDasCustomDepthFrameRequested(false);
+
+void AddDasCustomDepthConsumer()
+{
+	++snDasCustomDepthConsumers;
+}
+
+void RemoveDasCustomDepthConsumer()
+{
+	const int32 nPrevious = snDasCustomDepthConsumers--;
+	check(nPrevious > 0);
+}
+
+void RequestDasCustomDepthFrame()
+{
+	sbDasCustomDepthFrameRequested = true;
+}
+
+static std::atomic<uint32> snDasHoveredId(0);
+
+void SetDasHoveredId(uint32 nId)
+{
+	// 悬停变化要画出来，按需渲染下需要通知重绘
+	if (snDasHoveredId.exchange(nId) != nId)
+	{
+		FPrimitiveSceneProxy::NotifySceneChanged();
+	}
+}
+
+uint32 GetDasHoveredId()
+{
+	return snDasHoveredId;
+}
+
+bool ConsumeDasCustomDepthDemand()
+{
+	// 一次性请求在这里消费，持续使用者不清除
+	const bool bFrameRequested = sbDasCustomDepthFrameRequested.exchange(false);
+	return bFrameRequested || snDasCustomDepthConsumers > 0;
+}
+
+bool IsCustomDepthOcclusionCullingEnabled()
+{
+	// 描边和关闭深度的绘制需要被遮挡部分，HZB剔除会把它们挖掉
+	return CVarDasCustomDepthOcclusionCull.GetValueOnRenderThread() != 0
+		&& FPrimitiveSceneProxy::GetNumDasCustomDepthOcclusionExempt() == 0;
+}
+
 bool IsCustomDepthPassWritingStencil()
 {
 	return GetCustomDepthMode() == ECustomDepthMode::EnabledWithStencil;
 }
 
-FCustomDepthTextures FCustomDepthTextures::Create(FRDGBuilder& GraphBuilder, FIntPoint CustomDepthExtent, EShaderPlatform ShaderPlatform)
+FCustomDepthTextures FCustomDepthTextures::Create(FRDGBuilder& GraphBuilder, FIntPoint CustomDepthExtent, EShaderPlatform ShaderPlatform, bool bMemorylessDepth)
 {
 	const ECustomDepthMode CustomDepthMode = GetCustomDepthMode();
 
@@ -107,20 +169,33 @@ FCustomDepthTextures FCustomDepthTextures::Create(FRDGBuilder& GraphBuilder, FIn
 		CreateFlags |= TexCreate_NoFastClear;
 	}
 
+	//add Das 仅输出Das结果图时，自定义深度只在本pass内做深度测试，保留在tile内存中不回写
+	if (bMemorylessDepth)
+	{
+		CreateFlags = (CreateFlags & ~TexCreate_ShaderResource) | TexCreate_Memoryless;
+	}
+
 	const FRDGTextureDesc CustomDepthDesc = FRDGTextureDesc::Create2D(CustomDepthExtent, PF_DepthStencil, FClearValueBinding::DepthFar, CreateFlags);
 
 	CustomDepthTextures.Depth = GraphBuilder.CreateTexture(CustomDepthDesc, TEXT("CustomDepth"));
 
+	//add Das 预pass可见性ID模式下由计算pass写入Das结果图
+	ETextureCreateFlags DasCreateFlags = TexCreate_RenderTargetable | TexCreate_ShaderResource;
+	if (IsDasPrePassVisibilityIdsEnabled() && !IsMobilePlatform(ShaderPlatform))
+	{
+		DasCreateFlags |= TexCreate_UAV;
+	}
+
 	//add Das 补充线性深度图
-	const FRDGTextureDesc DasDepthDesc = FRDGTextureDesc::Create2D(CustomDepthExtent, PF_R8G8B8A8, FClearValueBinding::Black, TexCreate_RenderTargetable | TexCreate_ShaderResource);
+	const FRDGTextureDesc DasDepthDesc = FRDGTextureDesc::Create2D(CustomDepthExtent, PF_R8G8B8A8, FClearValueBinding::Black, DasCreateFlags);
 	CustomDepthTextures.DasDepth = GraphBuilder.CreateTexture(DasDepthDesc, TEXT("DasDepth"));
 
 	//add Das 补充蒙版图
-	const FRDGTextureDesc DasStencilDesc = FRDGTextureDesc::Create2D(CustomDepthExtent, PF_R8G8B8A8, FClearValueBinding::Black, TexCreate_RenderTargetable | TexCreate_ShaderResource);
+	const FRDGTextureDesc DasStencilDesc = FRDGTextureDesc::Create2D(CustomDepthExtent, PF_R8G8B8A8, FClearValueBinding::Black, DasCreateFlags);
 	CustomDepthTextures.DasStencil = GraphBuilder.CreateTexture(DasStencilDesc, TEXT("DasStencil"));
 
 	//add Das 补充自定义渲染图（描边）
-	const FRDGTextureDesc DasCustomDesc = FRDGTextureDesc::Create2D(CustomDepthExtent, PF_R8G8B8A8, FClearValueBinding::Transparent, TexCreate_RenderTargetable | TexCreate_ShaderResource);
+	const FRDGTextureDesc DasCustomDesc = FRDGTextureDesc::Create2D(CustomDepthExtent, PF_R8G8B8A8, FClearValueBinding::Transparent, DasCreateFlags);
 	CustomDepthTextures.DasCustom = GraphBuilder.CreateTexture(DasCustomDesc, TEXT("DasCustom"));
 	CustomDepthTextures.DasCustomDepthOn = GraphBuilder.CreateTexture(DasCustomDesc, TEXT("DasCustomDepthOn"));
 
@@ -194,6 +269,144 @@ static FNaniteCustomDepthDrawList BuildNaniteCustomDepthDrawList(const FViewInfo
 	return MoveTemp(Output);
 }
 
+class FDasVisibilityIdResolveCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FDasVisibilityIdResolveCS);
+	SHADER_USE_PARAMETER_STRUCT(FDasVisibilityIdResolveCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint4>, VisibilityIds)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D<float>, SceneDepthTexture)
+		SHADER_PARAMETER(FUintVector2, ViewRectMin)
+		SHADER_PARAMETER(FUintVector2, ViewRectSize)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, RWDasDepth)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, RWDasStencil)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, RWDasCustom)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, RWDasCustomDepthOn)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsDasPrePassVisibilityIdsEnabled() && IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), FComputeShaderUtils::kGolden2DGroupSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FDasVisibilityIdResolveCS, "/Engine/Private/DasVisibilityIdResolve.usf", "MainCS", SF_Compute);
+
+//add Das 解析可见性ID时不产出CustomDepth/CustomStencil，视图里有采样它们的材质时必须走几何pass
+static bool DoesViewSampleCustomDepthStencil(const FViewInfo& View)
+{
+	if (View.bUsesCustomDepth || View.bUsesCustomStencil)
+	{
+		return true;
+	}
+
+	const FBlendableManager& BlendableManager = View.FinalPostProcessSettings.BlendableManager;
+	FBlendableEntry* BlendableIt = nullptr;
+	while (FPostProcessMaterialNode* DataPtr = BlendableManager.IterateBlendables<FPostProcessMaterialNode>(BlendableIt))
+	{
+		if (DataPtr->IsValid())
+		{
+			FMaterialRenderProxy* Proxy = DataPtr->GetMaterialInterface()->GetRenderProxy();
+			check(Proxy);
+
+			const FMaterial& Material = Proxy->GetIncompleteMaterialWithFallback(View.GetFeatureLevel());
+			const FMaterialShaderMap* MaterialShaderMap = Material.GetRenderingThreadShaderMap();
+			if (Material.IsStencilTestEnabled() || MaterialShaderMap->UsesSceneTexture(PPI_CustomDepth) || MaterialShaderMap->UsesSceneTexture(PPI_CustomStencil))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+//add Das 把深度预pass的可见性ID解析成Das结果图，成功时不再需要自定义深度的几何pass
+static bool ResolveDasVisibilityIds(FRDGBuilder& GraphBuilder, TConstArrayView<FViewInfo> Views, const FCustomDepthTextures& CustomDepthTextures)
+{
+	const FDasVisibilityIdTextures* DasVisibilityIdTextures = GraphBuilder.Blackboard.Get<FDasVisibilityIdTextures>();
+	if (!DasVisibilityIdTextures || !EnumHasAnyFlags(CustomDepthTextures.DasStencil->Desc.Flags, TexCreate_UAV))
+	{
+		return false;
+	}
+
+	// 描边和关闭深度需要被遮挡的部分，预pass只有最前面的表面；半透明写自定义深度的物体不进预pass
+	if (FPrimitiveSceneProxy::GetNumDasCustomDepthOcclusionExempt() > 0 || FPrimitiveSceneProxy::GetNumDasTranslucentCustomDepthWriters() > 0)
+	{
+		return false;
+	}
+
+	// 需要CustomStencil或有人采样CustomDepth时，由几何pass产出
+	if (IsCustomDepthPassWritingStencil())
+	{
+		return false;
+	}
+
+	for (const FViewInfo& View : Views)
+	{
+		if (View.ShouldRenderView() && DoesViewSampleCustomDepthStencil(View))
+		{
+			return false;
+		}
+	}
+
+	RDG_EVENT_SCOPE(GraphBuilder, "DasVisibilityIdResolve");
+
+	FRDGTextureUAVRef DasDepthUAV = GraphBuilder.CreateUAV(CustomDepthTextures.DasDepth);
+	FRDGTextureUAVRef DasStencilUAV = GraphBuilder.CreateUAV(CustomDepthTextures.DasStencil);
+	FRDGTextureUAVRef DasCustomUAV = GraphBuilder.CreateUAV(CustomDepthTextures.DasCustom);
+	FRDGTextureUAVRef DasCustomDepthOnUAV = GraphBuilder.CreateUAV(CustomDepthTextures.DasCustomDepthOn);
+
+	// 视图没有覆盖整张图时先清掉，和几何pass的清除行为保持一致
+	const FIntPoint Extent = CustomDepthTextures.DasStencil->Desc.Extent;
+	if (Views.Num() != 1 || Views[0].ViewRect != FIntRect(FIntPoint::ZeroValue, Extent))
+	{
+		AddClearUAVPass(GraphBuilder, DasDepthUAV, FLinearColor::Black);
+		AddClearUAVPass(GraphBuilder, DasStencilUAV, FLinearColor::Black);
+		AddClearUAVPass(GraphBuilder, DasCustomUAV, FLinearColor::Transparent);
+		AddClearUAVPass(GraphBuilder, DasCustomDepthOnUAV, FLinearColor::Transparent);
+	}
+
+	for (const FViewInfo& View : Views)
+	{
+		if (!View.ShouldRenderView())
+		{
+			continue;
+		}
+
+		TShaderMapRef<FDasVisibilityIdResolveCS> ComputeShader(View.ShaderMap);
+
+		FDasVisibilityIdResolveCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FDasVisibilityIdResolveCS::FParameters>();
+		PassParameters->View = View.ViewUniformBuffer;
+		PassParameters->VisibilityIds = DasVisibilityIdTextures->VisibilityIds;
+		PassParameters->SceneDepthTexture = DasVisibilityIdTextures->SceneDepth;
+		PassParameters->ViewRectMin = FUintVector2(View.ViewRect.Min.X, View.ViewRect.Min.Y);
+		PassParameters->ViewRectSize = FUintVector2(View.ViewRect.Width(), View.ViewRect.Height());
+		PassParameters->RWDasDepth = DasDepthUAV;
+		PassParameters->RWDasStencil = DasStencilUAV;
+		PassParameters->RWDasCustom = DasCustomUAV;
+		PassParameters->RWDasCustomDepthOn = DasCustomDepthOnUAV;
+
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("Resolve %dx%d", View.ViewRect.Width(), View.ViewRect.Height()),
+			ComputeShader,
+			PassParameters,
+			FComputeShaderUtils::GetGroupCount(View.ViewRect.Size(), FComputeShaderUtils::kGolden2DGroupSize));
+	}
+
+	return true;
+}
+
 bool FSceneRenderer::RenderCustomDepthPass(
 	FRDGBuilder& GraphBuilder,
 	FCustomDepthTextures& CustomDepthTextures,
@@ -239,6 +452,18 @@ bool FSceneRenderer::RenderCustomDepthPass(
 
 	RDG_CSV_STAT_EXCLUSIVE_SCOPE(GraphBuilder, RenderCustomDepthPass);
 	RDG_GPU_STAT_SCOPE(GraphBuilder, CustomDepth);
+	FHitchRecorderScope HitchRecorderScope(EHitchRecorderTiming::CustomDepth);
+	FHitchRecorderGPUScope HitchRecorderGPUScope(GraphBuilder, EHitchRecorderTiming::CustomDepthGPU);
+
+	//add Das 预pass已输出可见性ID时，全屏解析替代几何pass
+	if (TotalNaniteInstances == 0 && ResolveDasVisibilityIds(GraphBuilder, Views, CustomDepthTextures))
+	{
+		return true;
+	}
+
+	//add Das 无内存的自定义深度不能跨pass保留，后面的视图读不到前一个视图的深度
+	checkf(Views.Num() == 1 || !EnumHasAnyFlags(CustomDepthTextures.Depth->Desc.Flags, TexCreate_Memoryless),
+		TEXT("Memoryless custom depth is only supported with a single view, got %d."), Views.Num());
 
 	// Render non-Nanite Custom Depth primitives
 	for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ++ViewIndex)
@@ -401,7 +626,7 @@ bool FSceneRenderer::RenderCustomDepthPass(
 				CustomDepthTextures.Stencil = GraphBuilder.CreateSRV(FRDGTextureSRVDesc::CreateWithPixelFormat(CustomStencil, PF_X24_G8));
 			}
 		}
-		else
+		else if (!EnumHasAnyFlags(CustomDepthTextures.Depth->Desc.Flags, TexCreate_Memoryless))
 		{
 			CustomDepthTextures.Stencil = GraphBuilder.CreateSRV(FRDGTextureSRVDesc::CreateWithPixelFormat(CustomDepthTextures.Depth, PF_X24_G8));
 		}
@@ -689,7 +914,8 @@ bool FCustomDepthPassMeshProcessor::Process(
 		MaterialResource.MaterialUsesPixelDepthOffset_RenderThread(),
 		DepthPassShaders.VertexShader,
 		DepthPassShaders.PixelShader,
-		ShaderPipeline
+		ShaderPipeline,
+		EDepthOnlyDasOutput::CustomDepth
 		))
 	{
 		return false;
@@ -819,7 +1045,8 @@ void FCustomDepthPassMeshProcessor::CollectPSOInitializers(
 		MaterialResource.MaterialUsesPixelDepthOffset_GameThread(),
 		DepthPassShaders.VertexShader,
 		DepthPassShaders.PixelShader,
-		ShaderPipeline
+		ShaderPipeline,
+		EDepthOnlyDasOutput::CustomDepth
 		))
 	{
 		return;
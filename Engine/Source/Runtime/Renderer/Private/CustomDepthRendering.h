@@ -39,9 +39,22 @@ inline bool IsCustomDepthPassEnabled()
 	return GetCustomDepthMode() != ECustomDepthMode::Disabled;
 }
 
+// Returns whether any Das pick / outline consumer needs custom depth this frame. Clears one-shot frame requests, so only call it for the main view family.
+extern bool ConsumeDasCustomDepthDemand();
+
+// Whether the CustomDepth mesh pass should be occlusion culled against the main view HZB during instance culling.
+extern bool IsCustomDepthOcclusionCullingEnabled();
+
+//add Das 深度预pass输出的可见性ID，通过RDG黑板交给自定义深度pass解析
+struct FDasVisibilityIdTextures
+{
+	FRDGTextureRef VisibilityIds{};
+	FRDGTextureRef SceneDepth{};
+};
+
 struct FCustomDepthTextures
 {
-	static FCustomDepthTextures Create(FRDGBuilder& GraphBuilder, FIntPoint CustomDepthExtent, EShaderPlatform ShaderPlatform);
+	static FCustomDepthTextures Create(FRDGBuilder& GraphBuilder, FIntPoint CustomDepthExtent, EShaderPlatform ShaderPlatform, bool bMemorylessDepth = false);
 
 	bool IsValid() const
 	{
@@ -0,0 +1,581 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+	DasBenchmark.cpp: Das custom depth pipeline benchmark.
+=============================================================================*/
+
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "UnrealClient.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInterface.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "UObject/StrongObjectPtr.h"
+#include "RenderCore.h"
+#include "RenderingThread.h"
+#include "RHI.h"
+#include "RHIGPUReadback.h"
+#include "SceneRenderTargetParameters.h"
+#include "HitchRecorder.h"
+#include "EngineLogs.h"
+
+/**
+ * Spawns a procedural scene exercising the Das custom depth pipeline in the game world, renders it for a number of frames and
+ * writes the averaged timings as JSON to Saved/Profiling/DasBenchmark: frame and thread times, setup and GPU time of the prepass,
+ * base pass and custom depth pass, the latency of a pick from RequestDasCustomDepthFrame to the DasStencil pixel read back on the
+ * CPU, and the memory of the Das targets the renderer allocated. The CPU side is meaningful under -nullrhi, so CI can run it on
+ * GPU-less machines, e.g. -nullrhi -ExecCmds="DasBenchmark Quit=1".
+ */
+class FDasBenchmark
+{
+public:
+	struct FSettings
+	{
+		int32 NumPrimitives = 1000;
+		int32 NumInstances = 10000;
+		int32 NumOutlined = 100;
+		int32 NumTranslucent = 100;
+		int32 NumWarmupFrames = 30;
+		int32 NumFrames = 300;
+		int32 PickInterval = 10;
+		FString TranslucentMaterialPath;
+		bool bQuitWhenDone = false;
+	};
+
+	static bool Start(UWorld* World, const FSettings& Settings);
+	static bool IsRunning() { return Running.IsValid(); }
+
+	/** JSON of the last finished run, empty until one finished. */
+	static const FString& GetLastReport() { return LastReport; }
+
+private:
+	FDasBenchmark(UWorld* InWorld, const FSettings& InSettings);
+
+	void SpawnScene();
+	void DestroyScene();
+	bool Tick(float DeltaTime);
+	void Report();
+	void RestoreState();
+	UMaterialInterface* GetTranslucentCustomDepthMaterial() const;
+
+	AStaticMeshActor* SpawnMeshActor(const FTransform& Transform, int32 DasStencilValue, int32 DasCustomValue, UMaterialInterface* Material);
+
+	struct FFrameTotals
+	{
+		double DeltaMs = 0.0;
+		double GameThreadMs = 0.0;
+		double RenderThreadMs = 0.0;
+		double RHIThreadMs = 0.0;
+		double GPUMs = 0.0;
+		double PrePassSetupMs = 0.0;
+		double BasePassSetupMs = 0.0;
+		double CustomDepthSetupMs = 0.0;
+		double PrePassGPUMs = 0.0;
+		double BasePassGPUMs = 0.0;
+		double CustomDepthGPUMs = 0.0;
+	};
+
+	/** Times picks from RequestDasCustomDepthFrame to the DasStencil pixel under the view centre read back on the CPU. Render thread. */
+	struct FPickProbe
+	{
+		void Tick(FRHICommandListImmediate& RHICmdList, bool bStartPick);
+
+		const FViewport* Viewport = nullptr;
+		TUniquePtr<FRHIGPUTextureReadback> Readback;
+		double RequestTime = 0.0;
+		bool bRequested = false;
+
+		double TotalLatencyMs = 0.0;
+		int32 NumPicks = 0;
+		int32 NumHits = 0;
+	};
+
+	TWeakObjectPtr<UWorld> World;
+	FSettings Settings;
+	TArray<TWeakObjectPtr<AActor>> SpawnedActors;
+	TStrongObjectPtr<UMaterialInterface> TranslucentMaterial;
+	FFrameTotals Totals;
+	TSharedPtr<FPickProbe, ESPMode::ThreadSafe> PickProbe;
+	int32 FrameIndex = 0;
+	bool bHitchRecorderWasEnabled = true;
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	static TUniquePtr<FDasBenchmark> Running;
+	static FString LastReport;
+};
+
+TUniquePtr<FDasBenchmark> FDasBenchmark::Running;
+FString FDasBenchmark::LastReport;
+
+FDasBenchmark::FDasBenchmark(UWorld* InWorld, const FSettings& InSettings)
+	: World(InWorld)
+	, Settings(InSettings)
+{
+}
+
+bool FDasBenchmark::Start(UWorld* World, const FSettings& Settings)
+{
+	if (Running)
+	{
+		UE_LOG(LogEngine, Warning, TEXT("DasBenchmark is already running."));
+		return false;
+	}
+
+	if (World == nullptr || !World->IsGameWorld())
+	{
+		UE_LOG(LogEngine, Warning, TEXT("DasBenchmark needs a game world."));
+		return false;
+	}
+
+	LastReport.Reset();
+	Running = TUniquePtr<FDasBenchmark>(new FDasBenchmark(World, Settings));
+	Running->SpawnScene();
+
+	// 拾取读回用游戏视口自己那次场景渲染的DasStencil
+	Running->PickProbe = MakeShared<FPickProbe, ESPMode::ThreadSafe>();
+	if (GEngine && GEngine->GameViewport && GEngine->GameViewport->Viewport)
+	{
+		Running->PickProbe->Viewport = GEngine->GameViewport->Viewport;
+		ENQUEUE_RENDER_COMMAND(DasBenchmarkAddExtracts)([Viewport = Running->PickProbe->Viewport](FRHICommandListImmediate& RHICmdList)
+		{
+			AddDasTextureExtractsUser(Viewport);
+		});
+	}
+
+	// 设置耗时来自hitch recorder的逐帧记录，测试期间强制打开
+	IConsoleVariable* HitchRecorderCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("t.HitchRecorder"));
+	Running->bHitchRecorderWasEnabled = HitchRecorderCVar ? HitchRecorderCVar->GetBool() : true;
+	if (HitchRecorderCVar)
+	{
+		HitchRecorderCVar->Set(true, ECVF_SetByCode);
+	}
+
+	Running->TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(Running.Get(), &FDasBenchmark::Tick));
+	return true;
+}
+
+void FDasBenchmark::FPickProbe::Tick(FRHICommandListImmediate& RHICmdList, bool bStartPick)
+{
+	if (Viewport == nullptr)
+	{
+		return;
+	}
+
+	if (Readback.IsValid())
+	{
+		if (Readback->IsReady())
+		{
+			int32 RowPitchInPixels = 0;
+			const uint32* Pixel = static_cast<const uint32*>(Readback->Lock(RowPitchInPixels));
+			NumHits += Pixel && *Pixel != 0 ? 1 : 0;
+			Readback->Unlock();
+
+			TotalLatencyMs += (FPlatformTime::Seconds() - RequestTime) * 1000.0;
+			++NumPicks;
+			Readback.Reset();
+			bRequested = false;
+		}
+		return;
+	}
+
+	if (bRequested)
+	{
+		// 请求之后的那次场景渲染已经在本命令之前，提取的就是为这次拾取画的DasStencil
+		const FDasTextureExtracts* DasExtracts = GetDasTextureExtracts(Viewport);
+		if (DasExtracts && DasExtracts->GetDasStencil())
+		{
+			const FIntPoint Center = DasExtracts->ViewRect.Min + DasExtracts->ViewRect.Size() / 2;
+			Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("DasBenchmarkPick"));
+			Readback->EnqueueCopy(RHICmdList, DasExtracts->GetDasStencil(), FResolveRect(Center.X, Center.Y, Center.X + 1, Center.Y + 1));
+		}
+		return;
+	}
+
+	if (bStartPick)
+	{
+		RequestDasCustomDepthFrame();
+		RequestTime = FPlatformTime::Seconds();
+		bRequested = true;
+	}
+}
+
+UMaterialInterface* FDasBenchmark::GetTranslucentCustomDepthMaterial() const
+{
+	// 半透明排序物体要真的写自定义深度，才能测到半透明的Das路径
+	if (!Settings.TranslucentMaterialPath.IsEmpty())
+	{
+		UMaterialInterface* Material = LoadObject<UMaterialInterface>(nullptr, *Settings.TranslucentMaterialPath);
+		if (Material == nullptr || !Material->IsTranslucencyWritingCustomDepth())
+		{
+			UE_LOG(LogEngine, Warning, TEXT("DasBenchmark: %s is not a translucent material that writes custom depth."), *Settings.TranslucentMaterialPath);
+			return nullptr;
+		}
+		return Material;
+	}
+
+#if WITH_EDITOR
+	UMaterial* Material = NewObject<UMaterial>(GetTransientPackage(), NAME_None, RF_Transient);
+	Material->BlendMode = BLEND_Translucent;
+	Material->bAllowTranslucentCustomDepthWrites = true;
+	Material->PostEditChange();
+	return Material;
+#else
+	UE_LOG(LogEngine, Warning, TEXT("DasBenchmark: cooked builds need TranslucentMaterial=<path> for the translucent objects, they are skipped."));
+	return nullptr;
+#endif
+}
+
+AStaticMeshActor* FDasBenchmark::SpawnMeshActor(const FTransform& Transform, int32 DasStencilValue, int32 DasCustomValue, UMaterialInterface* Material)
+{
+	static UStaticMesh* CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags = RF_Transient;
+	AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>(Transform.GetLocation(), Transform.Rotator(), SpawnParameters);
+	if (Actor == nullptr)
+	{
+		return nullptr;
+	}
+
+	UStaticMeshComponent* MeshComponent = Actor->GetStaticMeshComponent();
+	MeshComponent->SetMobility(EComponentMobility::Movable);
+	MeshComponent->SetStaticMesh(CubeMesh);
+	MeshComponent->SetWorldScale3D(Transform.GetScale3D());
+	if (Material)
+	{
+		MeshComponent->SetMaterial(0, Material);
+	}
+	MeshComponent->SetRenderCustomDepth(true);
+	MeshComponent->SetDasStencilValue(DasStencilValue);
+	MeshComponent->SetDasCustomValue(DasCustomValue);
+
+	SpawnedActors.Add(Actor);
+	return Actor;
+}
+
+void FDasBenchmark::SpawnScene()
+{
+	FVector Origin = FVector::ZeroVector;
+	FRotator Facing = FRotator::ZeroRotator;
+	if (APlayerController* PlayerController = World->GetFirstPlayerController())
+	{
+		if (PlayerController->PlayerCameraManager)
+		{
+			Origin = PlayerController->PlayerCameraManager->GetCameraLocation();
+			Facing = FRotator(0.0f, PlayerController->PlayerCameraManager->GetCameraRotation().Yaw, 0.0f);
+		}
+	}
+
+	// Lay everything out on a wall in front of the camera so it is in view and mostly unoccluded.
+	const double Spacing = 60.0;
+	const FVector Forward = Facing.Vector();
+	const FVector Right = FRotationMatrix(Facing).GetScaledAxis(EAxis::Y);
+	const FVector WallCenter = Origin + Forward * 3000.0;
+	auto GetGridTransform = [&](int32 Index, int32 NumPerRow, double Depth)
+	{
+		const double Column = (Index % NumPerRow) - NumPerRow * 0.5;
+		const double Row = (Index / NumPerRow) - NumPerRow * 0.5;
+		return FTransform(Facing, WallCenter + Forward * Depth + Right * Column * Spacing + FVector::UpVector * Row * Spacing, FVector(0.4));
+	};
+
+	// Das值从1开始，0表示不可选
+	int32 NextDasStencilValue = 1;
+
+	const int32 PrimitivesPerRow = FMath::Max(FMath::CeilToInt(FMath::Sqrt((float)Settings.NumPrimitives)), 1);
+	for (int32 Index = 0; Index < Settings.NumPrimitives; ++Index)
+	{
+		// DasCustom第一位表示描边
+		const int32 DasCustomValue = Index < Settings.NumOutlined ? 1 : 0;
+		SpawnMeshActor(GetGridTransform(Index, PrimitivesPerRow, 0.0), NextDasStencilValue++, DasCustomValue, nullptr);
+	}
+
+	TranslucentMaterial.Reset(Settings.NumTranslucent > 0 ? GetTranslucentCustomDepthMaterial() : nullptr);
+	if (TranslucentMaterial.IsValid())
+	{
+		const int32 TranslucentPerRow = FMath::Max(FMath::CeilToInt(FMath::Sqrt((float)Settings.NumTranslucent)), 1);
+		for (int32 Index = 0; Index < Settings.NumTranslucent; ++Index)
+		{
+			if (AStaticMeshActor* Actor = SpawnMeshActor(GetGridTransform(Index, TranslucentPerRow, -500.0), NextDasStencilValue++, 0, TranslucentMaterial.Get()))
+			{
+				Actor->GetStaticMeshComponent()->SetTranslucentSortPriority(Index);
+			}
+		}
+	}
+
+	if (Settings.NumInstances > 0)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags = RF_Transient;
+		AActor* InstancesActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+		UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent>(InstancesActor, NAME_None, RF_Transient);
+		Instances->SetMobility(EComponentMobility::Movable);
+		InstancesActor->SetRootComponent(Instances);
+		Instances->SetStaticMesh(LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube")));
+		Instances->SetRenderCustomDepth(true);
+		Instances->SetDasStencilValue(NextDasStencilValue++);
+		Instances->RegisterComponent();
+
+		TArray<FTransform> InstanceTransforms;
+		InstanceTransforms.Reserve(Settings.NumInstances);
+		const int32 InstancesPerRow = FMath::Max(FMath::CeilToInt(FMath::Sqrt((float)Settings.NumInstances)), 1);
+		for (int32 Index = 0; Index < Settings.NumInstances; ++Index)
+		{
+			FTransform Transform = GetGridTransform(Index, InstancesPerRow, 1000.0);
+			Transform.SetScale3D(FVector(0.2));
+			InstanceTransforms.Add(Transform);
+		}
+		Instances->AddInstances(InstanceTransforms, false, true);
+
+		SpawnedActors.Add(InstancesActor);
+	}
+}
+
+void FDasBenchmark::DestroyScene()
+{
+	for (const TWeakObjectPtr<AActor>& Actor : SpawnedActors)
+	{
+		if (Actor.IsValid())
+		{
+			Actor->Destroy();
+		}
+	}
+	SpawnedActors.Reset();
+}
+
+bool FDasBenchmark::Tick(float DeltaTime)
+{
+	if (!World.IsValid())
+	{
+		UE_LOG(LogEngine, Warning, TEXT("DasBenchmark aborted, the world went away."));
+		RestoreState();
+		Running.Reset();
+		return false;
+	}
+
+	// The first frames pay for proxy creation, PSO compilation and streaming.
+	if (FrameIndex++ >= Settings.NumWarmupFrames)
+	{
+		const FHitchRecorder& HitchRecorder = FHitchRecorder::Get();
+		Totals.DeltaMs += DeltaTime * 1000.0;
+		Totals.GameThreadMs += FPlatformTime::ToMilliseconds(GGameThreadTime);
+		Totals.RenderThreadMs += FPlatformTime::ToMilliseconds(GRenderThreadTime);
+		Totals.RHIThreadMs += FPlatformTime::ToMilliseconds(GRHIThreadTime);
+		Totals.GPUMs += FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+		Totals.PrePassSetupMs += HitchRecorder.GetLastFrameTimeMs(EHitchRecorderTiming::PrePass);
+		Totals.BasePassSetupMs += HitchRecorder.GetLastFrameTimeMs(EHitchRecorderTiming::BasePass);
+		Totals.CustomDepthSetupMs += HitchRecorder.GetLastFrameTimeMs(EHitchRecorderTiming::CustomDepth);
+		Totals.PrePassGPUMs += HitchRecorder.GetLastFrameTimeMs(EHitchRecorderTiming::PrePassGPU);
+		Totals.BasePassGPUMs += HitchRecorder.GetLastFrameTimeMs(EHitchRecorderTiming::BasePassGPU);
+		Totals.CustomDepthGPUMs += HitchRecorder.GetLastFrameTimeMs(EHitchRecorderTiming::CustomDepthGPU);
+
+		// 每隔几帧发起一次拾取，测请求到读回的完整往返
+		const bool bStartPick = Settings.PickInterval > 0 && (FrameIndex - Settings.NumWarmupFrames) % Settings.PickInterval == 0;
+		ENQUEUE_RENDER_COMMAND(DasBenchmarkPick)([PickProbe = PickProbe, bStartPick](FRHICommandListImmediate& RHICmdList)
+		{
+			PickProbe->Tick(RHICmdList, bStartPick);
+		});
+	}
+
+	if (FrameIndex < Settings.NumWarmupFrames + Settings.NumFrames)
+	{
+		return true;
+	}
+
+	Report();
+	DestroyScene();
+	RestoreState();
+
+	if (Settings.bQuitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false, TEXT("DasBenchmark"));
+	}
+
+	// Deleting ourselves is fine, the ticker removes the delegate once we return false.
+	Running.Reset();
+	return false;
+}
+
+void FDasBenchmark::RestoreState()
+{
+	TranslucentMaterial.Reset();
+
+	if (PickProbe->Viewport)
+	{
+		ENQUEUE_RENDER_COMMAND(DasBenchmarkRemoveExtracts)([Viewport = PickProbe->Viewport](FRHICommandListImmediate& RHICmdList)
+		{
+			RemoveDasTextureExtractsUser(Viewport);
+		});
+	}
+
+	if (IConsoleVariable* HitchRecorderCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("t.HitchRecorder")))
+	{
+		HitchRecorderCVar->Set(bHitchRecorderWasEnabled, ECVF_SetByCode);
+	}
+}
+
+void FDasBenchmark::Report()
+{
+	const double NumFrames = FMath::Max(Settings.NumFrames, 1);
+
+	// 渲染器最后一次场景渲染实际分配的Das结果图，移动端tile内存里的不占显存也不会被提取
+	uint64 DasTargetBytes = 0;
+	FIntPoint DasTargetExtent = FIntPoint::ZeroValue;
+	ENQUEUE_RENDER_COMMAND(DasBenchmarkTargetMemory)([&DasTargetBytes, &DasTargetExtent](FRHICommandListImmediate& RHICmdList)
+	{
+		const FSceneTextureExtracts& Extracts = GetSceneTextureExtracts();
+		for (FRHITexture* Texture : { Extracts.GetDasDepth(), Extracts.GetDasStencil(), Extracts.GetDasCustom(), Extracts.GetDasCustomDepthOn() })
+		{
+			if (Texture)
+			{
+				DasTargetBytes += RHIComputeMemorySize(Texture);
+				DasTargetExtent = DasTargetExtent.ComponentMax(Texture->GetSizeXY());
+			}
+		}
+	});
+	FlushRenderingCommands();
+
+	const double PickLatencyMs = PickProbe->NumPicks > 0 ? PickProbe->TotalLatencyMs / PickProbe->NumPicks : 0.0;
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetStringField(TEXT("RHI"), GDynamicRHI ? GDynamicRHI->GetName() : TEXT("None"));
+	Json->SetNumberField(TEXT("Primitives"), Settings.NumPrimitives);
+	Json->SetNumberField(TEXT("Instances"), Settings.NumInstances);
+	Json->SetNumberField(TEXT("Outlined"), Settings.NumOutlined);
+	Json->SetNumberField(TEXT("Translucent"), TranslucentMaterial.IsValid() ? Settings.NumTranslucent : 0);
+	Json->SetNumberField(TEXT("Frames"), Settings.NumFrames);
+	Json->SetNumberField(TEXT("FrameMs"), Totals.DeltaMs / NumFrames);
+	Json->SetNumberField(TEXT("GameThreadMs"), Totals.GameThreadMs / NumFrames);
+	Json->SetNumberField(TEXT("RenderThreadMs"), Totals.RenderThreadMs / NumFrames);
+	Json->SetNumberField(TEXT("RHIThreadMs"), Totals.RHIThreadMs / NumFrames);
+	Json->SetNumberField(TEXT("GPUMs"), Totals.GPUMs / NumFrames);
+	Json->SetNumberField(TEXT("PrePassSetupMs"), Totals.PrePassSetupMs / NumFrames);
+	Json->SetNumberField(TEXT("BasePassSetupMs"), Totals.BasePassSetupMs / NumFrames);
+	Json->SetNumberField(TEXT("CustomDepthSetupMs"), Totals.CustomDepthSetupMs / NumFrames);
+	Json->SetNumberField(TEXT("PrePassGPUMs"), Totals.PrePassGPUMs / NumFrames);
+	Json->SetNumberField(TEXT("BasePassGPUMs"), Totals.BasePassGPUMs / NumFrames);
+	Json->SetNumberField(TEXT("CustomDepthGPUMs"), Totals.CustomDepthGPUMs / NumFrames);
+	Json->SetNumberField(TEXT("Picks"), PickProbe->NumPicks);
+	Json->SetNumberField(TEXT("PickHits"), PickProbe->NumHits);
+	Json->SetNumberField(TEXT("PickLatencyMs"), PickLatencyMs);
+	Json->SetNumberField(TEXT("DasTargetWidth"), DasTargetExtent.X);
+	Json->SetNumberField(TEXT("DasTargetHeight"), DasTargetExtent.Y);
+	Json->SetNumberField(TEXT("DasTargetBytes"), (double)DasTargetBytes);
+
+	FString JsonString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+	FJsonSerializer::Serialize(Json, Writer);
+
+	const FString Filename = FPaths::ProfilingDir() / TEXT("DasBenchmark") / FString::Printf(TEXT("DasBenchmark_%s.json"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(JsonString, *Filename);
+	LastReport = JsonString;
+
+	UE_LOG(LogEngine, Display, TEXT("DasBenchmark: frame %.2fms, GT %.2fms, RT %.2fms, GPU %.2fms, CustomDepth setup %.3fms GPU %.3fms, pick %.2fms, Das targets %.1fMB. Saved to %s"),
+		Totals.DeltaMs / NumFrames, Totals.GameThreadMs / NumFrames, Totals.RenderThreadMs / NumFrames, Totals.GPUMs / NumFrames,
+		Totals.CustomDepthSetupMs / NumFrames, Totals.CustomDepthGPUMs / NumFrames, PickLatencyMs, DasTargetBytes / (1024.0 * 1024.0), *Filename);
+}
+
+static void RunDasBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	FDasBenchmark::FSettings Settings;
+	for (const FString& Arg : Args)
+	{
+		FParse::Value(*Arg, TEXT("Primitives="), Settings.NumPrimitives);
+		FParse::Value(*Arg, TEXT("Instances="), Settings.NumInstances);
+		FParse::Value(*Arg, TEXT("Outlined="), Settings.NumOutlined);
+		FParse::Value(*Arg, TEXT("Translucent="), Settings.NumTranslucent);
+		FParse::Value(*Arg, TEXT("Warmup="), Settings.NumWarmupFrames);
+		FParse::Value(*Arg, TEXT("Frames="), Settings.NumFrames);
+		FParse::Value(*Arg, TEXT("PickInterval="), Settings.PickInterval);
+		FParse::Value(*Arg, TEXT("TranslucentMaterial="), Settings.TranslucentMaterialPath);
+		FParse::Bool(*Arg, TEXT("Quit="), Settings.bQuitWhenDone);
+	}
+
+	Settings.NumPrimitives = FMath::Max(Settings.NumPrimitives, 0);
+	Settings.NumInstances = FMath::Max(Settings.NumInstances, 0);
+	Settings.NumOutlined = FMath::Clamp(Settings.NumOutlined, 0, Settings.NumPrimitives);
+	Settings.NumTranslucent = FMath::Max(Settings.NumTranslucent, 0);
+
+	FDasBenchmark::Start(World, Settings);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GDasBenchmarkCmd(
+	TEXT("DasBenchmark"),
+	TEXT("Spawns a procedural custom depth scene and reports Das pipeline timings as JSON in Saved/Profiling/DasBenchmark.\n")
+	TEXT("Optional: Primitives=1000 Instances=10000 Outlined=100 Translucent=100 Warmup=30 Frames=300 PickInterval=10 Quit=0.\n")
+	TEXT("TranslucentMaterial=<path> sets a translucent material writing custom depth, required in cooked builds. Runs under -nullrhi for CPU timings."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunDasBenchmark)
+	);
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+DEFINE_LATENT_AUTOMATION_COMMAND_ONE_PARAMETER(FDasBenchmarkCheckReportCommand, FAutomationTestBase*, Test);
+
+bool FDasBenchmarkCheckReportCommand::Update()
+{
+	if (FDasBenchmark::IsRunning())
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Json;
+	if (!Test->TestTrue(TEXT("DasBenchmark wrote a JSON report"), FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(FDasBenchmark::GetLastReport()), Json) && Json.IsValid()))
+	{
+		return true;
+	}
+
+	for (const TCHAR* Field : { TEXT("FrameMs"), TEXT("GameThreadMs"), TEXT("RenderThreadMs"), TEXT("GPUMs"), TEXT("PrePassSetupMs"), TEXT("BasePassSetupMs"),
+		TEXT("CustomDepthSetupMs"), TEXT("CustomDepthGPUMs"), TEXT("Picks"), TEXT("PickLatencyMs"), TEXT("DasTargetBytes") })
+	{
+		Test->TestTrue(FString::Printf(TEXT("Report has %s"), Field), Json->HasTypedField<EJson::Number>(Field));
+	}
+	Test->TestEqual(TEXT("Primitives"), (int32)Json->GetNumberField(TEXT("Primitives")), 100);
+	Test->TestEqual(TEXT("Frames"), (int32)Json->GetNumberField(TEXT("Frames")), 30);
+	Test->TestTrue(TEXT("FrameMs is positive"), Json->GetNumberField(TEXT("FrameMs")) > 0.0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDasBenchmarkTest, "System.Engine.Rendering.DasBenchmark", EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FDasBenchmarkTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = AutomationCommon::GetAnyGameWorld();
+	if (!TestNotNull(TEXT("DasBenchmark needs a game world"), World))
+	{
+		return false;
+	}
+
+	// 与控制台命令同一个场景，规模缩小到CI能跑完
+	FDasBenchmark::FSettings Settings;
+	Settings.NumPrimitives = 100;
+	Settings.NumInstances = 1000;
+	Settings.NumOutlined = 10;
+	Settings.NumTranslucent = 10;
+	Settings.NumWarmupFrames = 5;
+	Settings.NumFrames = 30;
+	Settings.PickInterval = 5;
+	if (!TestTrue(TEXT("DasBenchmark started"), FDasBenchmark::Start(World, Settings)))
+	{
+		return false;
+	}
+
+	ADD_LATENT_AUTOMATION_COMMAND(FDasBenchmarkCheckReportCommand(this));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
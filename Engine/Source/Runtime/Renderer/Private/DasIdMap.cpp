@@ -0,0 +1,67 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DasIdMap.h"
+#include "GlobalShader.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "ShaderParameterStruct.h"
+
+class FDasIdMapCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FDasIdMapCS);
+	SHADER_USE_PARAMETER_STRUCT(FDasIdMapCS, FGlobalShader);
+
+	static constexpr int32 ThreadGroupSize = 8;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DasStencilTexture)
+		SHADER_PARAMETER(FUintVector2, MaskMin)
+		SHADER_PARAMETER(FUintVector2, MaskMax)
+		SHADER_PARAMETER(FVector2f, CellToMaskScale)
+		SHADER_PARAMETER(FUintVector2, OutExtent)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, RWIds)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), ThreadGroupSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FDasIdMapCS, "/Engine/Private/DasIdMap.usf", "MainCS", SF_Compute);
+
+FRDGBufferRef AddDasIdMapPass(FRDGBuilder& GraphBuilder, FRDGTextureRef DasStencilTexture, FIntRect MaskRect, FIntPoint OutExtent)
+{
+	if (MaskRect.IsEmpty())
+	{
+		MaskRect = FIntRect(FIntPoint::ZeroValue, DasStencilTexture->Desc.Extent);
+	}
+
+	FRDGBufferRef Ids = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), OutExtent.X * OutExtent.Y), TEXT("DasIdMap"));
+
+	FDasIdMapCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FDasIdMapCS::FParameters>();
+	PassParameters->DasStencilTexture = DasStencilTexture;
+	PassParameters->MaskMin = FUintVector2(MaskRect.Min.X, MaskRect.Min.Y);
+	PassParameters->MaskMax = FUintVector2(MaskRect.Max.X, MaskRect.Max.Y);
+	PassParameters->CellToMaskScale = FVector2f((float)MaskRect.Width() / OutExtent.X, (float)MaskRect.Height() / OutExtent.Y);
+	PassParameters->OutExtent = FUintVector2(OutExtent.X, OutExtent.Y);
+	PassParameters->RWIds = GraphBuilder.CreateUAV(Ids);
+
+	TShaderMapRef<FDasIdMapCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("DasIdMap %dx%d", OutExtent.X, OutExtent.Y),
+		ComputeShader,
+		PassParameters,
+		FComputeShaderUtils::GetGroupCount(OutExtent, FDasIdMapCS::ThreadGroupSize));
+
+	return Ids;
+}
@@ -37,6 +37,8 @@
 #include "SimpleMeshDrawCommandPass.h"
 #include "UnrealEngine.h"
 #include "DepthCopy.h"
+#include "CustomDepthRendering.h"
+#include "HitchRecorder.h"
 
 static TAutoConsoleVariable<int32> CVarParallelPrePass(
 	TEXT("r.ParallelPrePass"),
@@ -83,6 +85,21 @@ static TAutoConsoleVariable<int32> CVarPSOPrecacheDitheredLODFadingOutMaskPass(
 	ECVF_ReadOnly
 );
 
+//add Das 深度预pass输出Das可见性ID，解析后替代自定义深度的几何pass
+static TAutoConsoleVariable<int32> CVarDasPrePassVisibilityIds(
+	TEXT("r.Das.PrePassVisibilityIds"),
+	0,
+	TEXT("Whether the depth prepass writes packed Das visibility IDs that are resolved into the Das textures instead of running the CustomDepth geometry pass.\n")
+	TEXT(" 0: Off, the Das textures come from the CustomDepth pass [default]\n")
+	TEXT(" 1: On, requires a full opaque prepass (r.EarlyZPass 2). Primitives with a Das stencil value or custom depth then run a pixel shader and write their ID and depth, everything else stays depth only.\n")
+	TEXT("Falls back to the CustomDepth pass while outline, depth-off, Nanite or translucent custom depth primitives exist, with r.CustomDepth 3, or when a view samples CustomDepth / CustomStencil."),
+	ECVF_RenderThreadSafe | ECVF_ReadOnly);
+
+bool IsDasPrePassVisibilityIdsEnabled()
+{
+	return CVarDasPrePassVisibilityIds.GetValueOnAnyThread() != 0;
+}
+
 extern bool IsHMDHiddenAreaMaskActive();
 
 FDepthPassInfo GetDepthPassInfo(const FScene* Scene)
@@ -170,13 +187,14 @@ bool GetDepthPassShaders(
 	bool bMaterialUsesPixelDepthOffset,
 	TShaderRef<TDepthOnlyVS<bPositionOnly>>& VertexShader,
 	TShaderRef<FDepthOnlyPS>& PixelShader,
-	FShaderPipelineRef& ShaderPipeline)
+	FShaderPipelineRef& ShaderPipeline,
+	EDepthOnlyDasOutput DasOutput)
 {
 	FMaterialShaderTypes ShaderTypes;
-	ShaderTypes.AddShaderType<TDepthOnlyVS<bPositionOnly>>();
 
 	if (bPositionOnly)
 	{
+		ShaderTypes.AddShaderType<TDepthOnlyVS<bPositionOnly>>();
 		ShaderTypes.PipelineType = &DepthPosOnlyNoPixelPipeline;
 		/*ShaderPipeline = UseShaderPipelines(FeatureLevel) ? Material.GetShaderPipeline(&DepthPosOnlyNoPixelPipeline, VertexFactoryType) : FShaderPipelineRef();
 		VertexShader = ShaderPipeline.IsValid()
@@ -187,14 +205,28 @@ bool GetDepthPassShaders(
 	else
 	{
 		const bool bVFTypeSupportsNullPixelShader = VertexFactoryType->SupportsNullPixelShader();
-		const bool bNeedsPixelShader = !Material.WritesEveryPixel(false, bVFTypeSupportsNullPixelShader) || bMaterialUsesPixelDepthOffset || Material.IsTranslucencyWritingCustomDepth();
+		const bool bNeedsPixelShader = !Material.WritesEveryPixel(false, bVFTypeSupportsNullPixelShader) || bMaterialUsesPixelDepthOffset || Material.IsTranslucencyWritingCustomDepth()
+			|| DasOutput == EDepthOnlyDasOutput::VisibilityId;
 		if (bNeedsPixelShader)
 		{
-			ShaderTypes.AddShaderType<FDepthOnlyPS>();
-			ShaderTypes.PipelineType = &DepthPipeline;
+			// Only passes that export Das outputs pay for the Das interpolants and MRTs, the prepass stays lean.
+			typename TDepthOnlyVS<bPositionOnly>::FPermutationDomain VSPermutationVector;
+			VSPermutationVector.template Set<typename TDepthOnlyVS<bPositionOnly>::FDasInterpolantsDim>(DasOutput != EDepthOnlyDasOutput::None);
+			ShaderTypes.AddShaderType<TDepthOnlyVS<bPositionOnly>>(VSPermutationVector.ToDimensionValueId());
+
+			FDepthOnlyPS::FPermutationDomain PSPermutationVector;
+			PSPermutationVector.Set<FDepthOnlyPS::FDasOutputDim>(DasOutput);
+			ShaderTypes.AddShaderType<FDepthOnlyPS>(PSPermutationVector.ToDimensionValueId());
+
+			// The shader pipeline only references the default permutations.
+			if (DasOutput == EDepthOnlyDasOutput::None)
+			{
+				ShaderTypes.PipelineType = &DepthPipeline;
+			}
 		}
 		else
 		{
+			ShaderTypes.AddShaderType<TDepthOnlyVS<bPositionOnly>>();
 			ShaderTypes.PipelineType = &DepthNoPixelPipeline;
 		}
 	}
@@ -219,7 +251,8 @@ bool GetDepthPassShaders(
 		bool bMaterialUsesPixelDepthOffset, \
 		TShaderRef<TDepthOnlyVS<bPositionOnly>>& VertexShader, \
 		TShaderRef<FDepthOnlyPS>& PixelShader, \
-		FShaderPipelineRef& ShaderPipeline \
+		FShaderPipelineRef& ShaderPipeline, \
+		EDepthOnlyDasOutput DasOutput \
 	);
 
 IMPLEMENT_GetDepthPassShaders( true );
@@ -491,11 +524,34 @@ void FDeferredShadingSceneRenderer::RenderPrePass(FRDGBuilder& GraphBuilder, FRD
 
 	SCOPED_NAMED_EVENT(FDeferredShadingSceneRenderer_RenderPrePass, FColor::Emerald);
 	SCOPE_CYCLE_COUNTER(STAT_DepthDrawTime);
+	FHitchRecorderScope HitchRecorderScope(EHitchRecorderTiming::PrePass);
+	FHitchRecorderGPUScope HitchRecorderGPUScope(GraphBuilder, EHitchRecorderTiming::PrePassGPU);
 
 	const bool bParallelDepthPass = GRHICommandList.UseParallelAlgorithms() && CVarParallelPrePass.GetValueOnRenderThread();
 
 	RenderPrePassHMD(GraphBuilder, SceneDepthTexture);
 
+	//add Das 完整的不透明预pass顺带输出Das可见性ID，在自定义深度pass里解析成Das结果图
+	FRDGTextureRef DasVisibilityIds = nullptr;
+	if (DepthPass.EarlyZPassMode == DDM_AllOpaque && IsDasPrePassVisibilityIdsEnabled() && SceneDepthTexture->Desc.NumSamples == 1)
+	{
+		bool bAnyCustomDepth = false;
+		for (const FViewInfo& View : Views)
+		{
+			bAnyCustomDepth |= View.ShouldRenderView() && View.bHasCustomDepthPrimitives;
+		}
+
+		if (bAnyCustomDepth)
+		{
+			const FRDGTextureDesc VisibilityIdsDesc = FRDGTextureDesc::Create2D(SceneDepthTexture->Desc.Extent, PF_R32G32B32A32_UINT, FClearValueBinding::Black, TexCreate_RenderTargetable | TexCreate_ShaderResource);
+			DasVisibilityIds = GraphBuilder.CreateTexture(VisibilityIdsDesc, TEXT("DasVisibilityIds"));
+
+			FDasVisibilityIdTextures& DasVisibilityIdTextures = GraphBuilder.Blackboard.Create<FDasVisibilityIdTextures>();
+			DasVisibilityIdTextures.VisibilityIds = DasVisibilityIds;
+			DasVisibilityIdTextures.SceneDepth = SceneDepthTexture;
+		}
+	}
+
 	if (DepthPass.IsRasterStencilDitherEnabled())
 	{
 		AddDitheredStencilFillPass(GraphBuilder, Views, SceneDepthTexture, DepthPass);
@@ -525,6 +581,10 @@ void FDeferredShadingSceneRenderer::RenderPrePass(FRDGBuilder& GraphBuilder, FRD
 					View.BeginRenderView();
 
 					FDepthPassParameters* PassParameters = GetDepthPassParameters(GraphBuilder, View, SceneDepthTexture);
+					if (DasVisibilityIds && !bSecondStageDepthPass)
+					{
+						PassParameters->RenderTargets[0] = FRenderTargetBinding(DasVisibilityIds, GetLoadActionIfProduced(DasVisibilityIds, ERenderTargetLoadAction::EClear));
+					}
 					View.ParallelMeshDrawCommandPasses[DepthMeshPass].BuildRenderingCommands(GraphBuilder, Scene->GPUScene, PassParameters->InstanceCullingDrawParams);
 
 					GraphBuilder.AddPass(
@@ -559,6 +619,10 @@ void FDeferredShadingSceneRenderer::RenderPrePass(FRDGBuilder& GraphBuilder, FRD
 					View.BeginRenderView();
 
 					FDepthPassParameters* PassParameters = GetDepthPassParameters(GraphBuilder, View, SceneDepthTexture);
+					if (DasVisibilityIds && !bSecondStageDepthPass)
+					{
+						PassParameters->RenderTargets[0] = FRenderTargetBinding(DasVisibilityIds, GetLoadActionIfProduced(DasVisibilityIds, ERenderTargetLoadAction::EClear));
+					}
 					View.ParallelMeshDrawCommandPasses[DepthMeshPass].BuildRenderingCommands(GraphBuilder, Scene->GPUScene, PassParameters->InstanceCullingDrawParams);
 
 					GraphBuilder.AddPass(
@@ -783,7 +847,8 @@ bool FDepthPassMeshProcessor::Process(
 	const FMaterialRenderProxy& RESTRICT MaterialRenderProxy,
 	const FMaterial& RESTRICT MaterialResource,
 	ERasterizerFillMode MeshFillMode,
-	ERasterizerCullMode MeshCullMode)
+	ERasterizerCullMode MeshCullMode,
+	bool bWriteDasVisibilityId)
 {
 	const FVertexFactory* VertexFactory = MeshBatch.VertexFactory;
 
@@ -800,7 +865,8 @@ bool FDepthPassMeshProcessor::Process(
 		MaterialResource.MaterialUsesPixelDepthOffset_RenderThread(),
 		DepthPassShaders.VertexShader,
 		DepthPassShaders.PixelShader,
-		ShaderPipeline))
+		ShaderPipeline,
+		bWriteDasVisibilityId ? EDepthOnlyDasOutput::VisibilityId : EDepthOnlyDasOutput::None))
 	{
 		return false;
 	}
@@ -819,6 +885,16 @@ bool FDepthPassMeshProcessor::Process(
 	}
 
 	FDepthOnlyShaderElementData ShaderElementData(0, 0);
+	if (bWriteDasVisibilityId)
+	{
+		//add Das 写可见性ID和深度，描边位由自定义深度pass处理。解析时深度对不上说明被只写深度的物体挡住
+		DrawRenderState.SetBlendState(TStaticBlendState<CW_RGB>::GetRHI());
+		if (PrimitiveSceneProxy && PrimitiveSceneProxy->ShouldRenderCustomDepth())
+		{
+			ShaderElementData.DasStencil = PrimitiveSceneProxy->GetDasStencilValue();
+			ShaderElementData.DasCustom = PrimitiveSceneProxy->GetDasCustomValue() & ~1;
+		}
+	}
 	ShaderElementData.InitializeMeshMaterialData(ViewIfDynamicMeshCommand, PrimitiveSceneProxy, MeshBatch, StaticMeshId, true);
 
 	const bool bIsMasked = IsMaskedBlendMode(MaterialResource);
@@ -929,6 +1005,17 @@ bool FDepthPassMeshProcessor::UseDefaultMaterial(const FMaterial& Material, bool
 	return bUseDefaultMaterial;
 }
 
+bool FDepthPassMeshProcessor::ShouldWriteDasVisibilityId(const FPrimitiveSceneProxy* RESTRICT PrimitiveSceneProxy) const
+{
+	// 只有主预pass输出ID，第二阶段、LOD渐隐遮罩和阴影投射不参与。其他物体保持DepthNoPixel，遮挡由解析时的深度比较处理
+	return MeshPassType == EMeshPass::DepthPass
+		&& !bShadowProjection
+		&& FeatureLevel >= ERHIFeatureLevel::SM5
+		&& IsDasPrePassVisibilityIdsEnabled()
+		&& PrimitiveSceneProxy
+		&& (PrimitiveSceneProxy->GetDasStencilValue() != 0 || PrimitiveSceneProxy->ShouldRenderCustomDepth());
+}
+
 bool FDepthPassMeshProcessor::TryAddMeshBatch(const FMeshBatch& RESTRICT MeshBatch, uint64 BatchElementMask, const FPrimitiveSceneProxy* RESTRICT PrimitiveSceneProxy, int32 StaticMeshId, const FMaterialRenderProxy& MaterialRenderProxy, const FMaterial& Material)
 {
 	const bool bIsTranslucent = IsTranslucentBlendMode(Material);
@@ -947,6 +1034,13 @@ bool FDepthPassMeshProcessor::TryAddMeshBatch(const FMeshBatch& RESTRICT MeshBat
 		bool bPositionOnly = false;
 		bool bUseDefaultMaterial = UseDefaultMaterial(Material, bEvaluateWPO, bSupportPositionOnlyStream, bVFTypeSupportsNullPixelShader, bPositionOnly);
 
+		//add Das 输出可见性ID需要像素着色器，不能走只有位置流的路径
+		const bool bWriteDasVisibilityId = ShouldWriteDasVisibilityId(PrimitiveSceneProxy);
+		if (bWriteDasVisibilityId)
+		{
+			bPositionOnly = false;
+		}
+
 		const FMaterialRenderProxy* EffectiveMaterialRenderProxy = &MaterialRenderProxy;
 		const FMaterial* EffectiveMaterial = &Material;
 		if (bUseDefaultMaterial)
@@ -967,7 +1061,7 @@ bool FDepthPassMeshProcessor::TryAddMeshBatch(const FMeshBatch& RESTRICT MeshBat
 		}
 		else
 		{
-			bResult = Process<false>(MeshBatch, BatchElementMask, StaticMeshId, PrimitiveSceneProxy, *EffectiveMaterialRenderProxy, *EffectiveMaterial, MeshFillMode, MeshCullMode);
+			bResult = Process<false>(MeshBatch, BatchElementMask, StaticMeshId, PrimitiveSceneProxy, *EffectiveMaterialRenderProxy, *EffectiveMaterial, MeshFillMode, MeshCullMode, bWriteDasVisibilityId);
 		}
 	}
 
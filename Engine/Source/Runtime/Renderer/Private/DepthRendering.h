@@ -35,6 +35,46 @@ enum EDepthDrawingMode
 
 extern const TCHAR* GetDepthDrawingModeString(EDepthDrawingMode Mode);
 
+//add Das FDepthOnlyPS输出的Das信息
+enum class EDepthOnlyDasOutput : uint8
+{
+	// 不输出Das信息，主预pass和遮罩预pass使用
+	None,
+	// 自定义深度pass的四张Das结果图
+	CustomDepth,
+	// 深度预pass输出的打包可见性ID(蒙版值、状态值)
+	VisibilityId,
+	MAX
+};
+
+// Whether the depth prepass writes Das visibility IDs in place of the CustomDepth geometry pass (r.Das.PrePassVisibilityIds).
+extern bool IsDasPrePassVisibilityIdsEnabled();
+
+// Whether FDepthOnlyPS compiles the given Das output permutation for this material. TDepthOnlyVS compiles its Das interpolants for the same set.
+inline bool ShouldCompileDepthOnlyDasOutput(const FMeshMaterialShaderPermutationParameters& Parameters, EDepthOnlyDasOutput DasOutput)
+{
+	const bool bIsTranslucent = IsTranslucentBlendMode(Parameters.MaterialParameters);
+	const bool bIsMasked = !Parameters.MaterialParameters.bWritesEveryPixel || Parameters.MaterialParameters.bHasPixelDepthOffsetConnected;
+	const bool bIsNanite = Parameters.VertexFactoryType->SupportsNaniteRendering();
+
+	switch (DasOutput)
+	{
+	case EDepthOnlyDasOutput::None:
+		// Translucent materials only write depth in the CustomDepth pass.
+		return !bIsTranslucent && bIsMasked && !bIsNanite;
+	case EDepthOnlyDasOutput::CustomDepth:
+		return bIsTranslucent ? Parameters.MaterialParameters.bIsTranslucencyWritingCustomDepth : (bIsMasked && !bIsNanite);
+	case EDepthOnlyDasOutput::VisibilityId:
+		// 写ID的物体可能用任意不透明材质，包括WPO材质和替换成默认材质的情况
+		return IsDasPrePassVisibilityIdsEnabled()
+			&& IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5)
+			&& !bIsTranslucent
+			&& !bIsNanite;
+	}
+
+	return false;
+}
+
 struct FDepthPassInfo
 {
 	bool IsComputeStencilDitherEnabled() const
@@ -66,6 +106,10 @@ template <bool bUsePositionOnlyStream>
 class TDepthOnlyVS : public FMeshMaterialShader
 {
 	DECLARE_SHADER_TYPE(TDepthOnlyVS,MeshMaterial);
+public:
+	class FDasInterpolantsDim : SHADER_PERMUTATION_BOOL("DAS_INTERPOLANTS");
+	using FPermutationDomain = TShaderPermutationDomain<FDasInterpolantsDim>;
+
 protected:
 
 	TDepthOnlyVS() {}
@@ -78,6 +122,14 @@ public:
 
 	static bool ShouldCompilePermutation(const FMeshMaterialShaderPermutationParameters& Parameters)
 	{
+		const FPermutationDomain PermutationVector(Parameters.PermutationId);
+		if (PermutationVector.Get<FDasInterpolantsDim>())
+		{
+			// Das interpolants are only read by the pixel shaders that export Das outputs.
+			return !bUsePositionOnlyStream
+				&& (ShouldCompileDepthOnlyDasOutput(Parameters, EDepthOnlyDasOutput::CustomDepth) || ShouldCompileDepthOnlyDasOutput(Parameters, EDepthOnlyDasOutput::VisibilityId));
+		}
+
 		// Only the local vertex factory supports the position-only stream
 		if (bUsePositionOnlyStream)
 		{
@@ -143,17 +195,13 @@ class FDepthOnlyPS : public FMeshMaterialShader
 {
 	DECLARE_SHADER_TYPE(FDepthOnlyPS,MeshMaterial);
 public:
+	class FDasOutputDim : SHADER_PERMUTATION_ENUM_CLASS("DAS_DEPTH_OUTPUT", EDepthOnlyDasOutput);
+	using FPermutationDomain = TShaderPermutationDomain<FDasOutputDim>;
+
 	static bool ShouldCompilePermutation(const FMeshMaterialShaderPermutationParameters& Parameters)
 	{
-		if (IsTranslucentBlendMode(Parameters.MaterialParameters))
-		{
-			return Parameters.MaterialParameters.bIsTranslucencyWritingCustomDepth;
-		}
-		
-		return
-			// Compile for materials that are masked
-			(!Parameters.MaterialParameters.bWritesEveryPixel || Parameters.MaterialParameters.bHasPixelDepthOffsetConnected)
-			&& !Parameters.VertexFactoryType->SupportsNaniteRendering();
+		const FPermutationDomain PermutationVector(Parameters.PermutationId);
+		return ShouldCompileDepthOnlyDasOutput(Parameters, PermutationVector.Get<FDasOutputDim>());
 	}
 
 	FDepthOnlyPS(const ShaderMetaType::CompiledShaderInitializerType& Initializer):
@@ -207,7 +255,8 @@ bool GetDepthPassShaders(
 	bool bMaterialUsesPixelDepthOffset,
 	TShaderRef<TDepthOnlyVS<bPositionOnly>>& VertexShader,
 	TShaderRef<FDepthOnlyPS>& PixelShader,
-	FShaderPipelineRef& ShaderPipeline);
+	FShaderPipelineRef& ShaderPipeline,
+	EDepthOnlyDasOutput DasOutput = EDepthOnlyDasOutput::None);
 
 class FDepthPassMeshProcessor : public FSceneRenderingAllocatorObject<FDepthPassMeshProcessor>, public FMeshPassProcessor
 {
@@ -234,6 +283,9 @@ public:
 private:
 
 	bool TryAddMeshBatch(const FMeshBatch& RESTRICT MeshBatch, uint64 BatchElementMask, const FPrimitiveSceneProxy* RESTRICT PrimitiveSceneProxy, int32 StaticMeshId, const FMaterialRenderProxy& MaterialRenderProxy, const FMaterial& Material);
+
+	//add Das 预pass输出Das可见性ID
+	bool ShouldWriteDasVisibilityId(const FPrimitiveSceneProxy* RESTRICT PrimitiveSceneProxy) const;
 	
 	template<bool bPositionOnly>
 	bool Process(
@@ -244,7 +296,8 @@ private:
 		const FMaterialRenderProxy& RESTRICT MaterialRenderProxy,
 		const FMaterial& RESTRICT MaterialResource,
 		ERasterizerFillMode MeshFillMode,
-		ERasterizerCullMode MeshCullMode);
+		ERasterizerCullMode MeshCullMode,
+		bool bWriteDasVisibilityId = false);
 
 	bool UseDefaultMaterial(const FMaterial& Material, bool bMaterialModifiesMeshPosition, bool bSupportPositionOnlyStream, bool bVFTypeSupportsNullPixelShader, bool& bPositionOnly);
 
@@ -0,0 +1,86 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "FrameRoiMap.h"
+#include "GlobalShader.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "ShaderParameterStruct.h"
+
+class FFrameRoiMapCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FFrameRoiMapCS);
+	SHADER_USE_PARAMETER_STRUCT(FFrameRoiMapCS, FGlobalShader);
+
+	static constexpr int32 ThreadGroupSize = 8;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DasCustomTexture)
+		SHADER_PARAMETER(FUintVector2, FrameExtent)
+		SHADER_PARAMETER(FUintVector2, MaskMin)
+		SHADER_PARAMETER(FUintVector2, MaskMax)
+		SHADER_PARAMETER(FVector2f, FrameToMaskScale)
+		SHADER_PARAMETER(uint32, NumBlocksX)
+		SHADER_PARAMETER(int32, RoiQPOffset)
+		SHADER_PARAMETER(int32, BackgroundQPOffset)
+		SHADER_PARAMETER(uint32, NumFocusPoints)
+		SHADER_PARAMETER(float, FocusRadius)
+		SHADER_PARAMETER_ARRAY(FVector4f, FocusPoints, [FrameRoiMapMaxFocusPoints])
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<int>, RWQPOffsets)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), ThreadGroupSize);
+		OutEnvironment.SetDefine(TEXT("BLOCK_SIZE"), FrameRoiMapBlockSize);
+		OutEnvironment.SetDefine(TEXT("MAX_FOCUS_POINTS"), FrameRoiMapMaxFocusPoints);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FFrameRoiMapCS, "/Engine/Private/FrameRoiMap.usf", "MainCS", SF_Compute);
+
+FRDGBufferRef AddFrameRoiMapPass(FRDGBuilder& GraphBuilder, FRDGTextureRef DasCustomTexture, const FFrameRoiMapSettings& Settings)
+{
+	static_assert(FrameRoiMapBlockSize % FFrameRoiMapCS::ThreadGroupSize == 0, "Block size must be a multiple of the thread group size.");
+
+	const FIntPoint NumBlocks = GetFrameRoiMapNumBlocks(Settings.FrameExtent);
+	const FIntRect MaskRect = Settings.MaskRect.IsEmpty() ? FIntRect(FIntPoint::ZeroValue, DasCustomTexture->Desc.Extent) : Settings.MaskRect;
+
+	FRDGBufferRef QPOffsets = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateStructuredDesc(sizeof(int32), NumBlocks.X * NumBlocks.Y), TEXT("FrameRoiMapQPOffsets"));
+
+	FFrameRoiMapCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FFrameRoiMapCS::FParameters>();
+	PassParameters->DasCustomTexture = DasCustomTexture;
+	PassParameters->FrameExtent = FUintVector2(Settings.FrameExtent.X, Settings.FrameExtent.Y);
+	PassParameters->MaskMin = FUintVector2(MaskRect.Min.X, MaskRect.Min.Y);
+	PassParameters->MaskMax = FUintVector2(MaskRect.Max.X, MaskRect.Max.Y);
+	PassParameters->FrameToMaskScale = FVector2f(
+		(float)MaskRect.Width() / FMath::Max(Settings.FrameExtent.X, 1),
+		(float)MaskRect.Height() / FMath::Max(Settings.FrameExtent.Y, 1));
+	PassParameters->NumBlocksX = NumBlocks.X;
+	PassParameters->RoiQPOffset = Settings.RoiQPOffset;
+	PassParameters->BackgroundQPOffset = Settings.BackgroundQPOffset;
+	PassParameters->NumFocusPoints = FMath::Min(Settings.FocusPoints.Num(), FrameRoiMapMaxFocusPoints);
+	PassParameters->FocusRadius = (float)Settings.FocusRadius;
+	for (uint32 Index = 0; Index < PassParameters->NumFocusPoints; ++Index)
+	{
+		PassParameters->FocusPoints[Index] = FVector4f(Settings.FocusPoints[Index].X, Settings.FocusPoints[Index].Y, 0.0f, 0.0f);
+	}
+	PassParameters->RWQPOffsets = GraphBuilder.CreateUAV(QPOffsets);
+
+	TShaderMapRef<FFrameRoiMapCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("FrameRoiMap %dx%d", Settings.FrameExtent.X, Settings.FrameExtent.Y),
+		ComputeShader,
+		PassParameters,
+		FIntVector(NumBlocks.X, NumBlocks.Y, 1));
+
+	return QPOffsets;
+}
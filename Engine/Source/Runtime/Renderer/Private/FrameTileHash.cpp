@@ -0,0 +1,64 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "FrameTileHash.h"
+#include "GlobalShader.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "ShaderParameterStruct.h"
+
+class FFrameTileHashCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FFrameTileHashCS);
+	SHADER_USE_PARAMETER_STRUCT(FFrameTileHashCS, FGlobalShader);
+
+	static constexpr int32 ThreadGroupSize = 8;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, InputTexture)
+		SHADER_PARAMETER(FUintVector2, InputExtent)
+		SHADER_PARAMETER(uint32, NumTilesX)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, RWTileHashes)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), ThreadGroupSize);
+		OutEnvironment.SetDefine(TEXT("TILE_SIZE"), FrameTileHashTileSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FFrameTileHashCS, "/Engine/Private/FrameTileHash.usf", "MainCS", SF_Compute);
+
+FRDGBufferRef AddFrameTileHashPass(FRDGBuilder& GraphBuilder, FRDGTextureRef Texture)
+{
+	static_assert(FrameTileHashTileSize % FFrameTileHashCS::ThreadGroupSize == 0, "Tile size must be a multiple of the thread group size.");
+
+	const FIntPoint Extent = Texture->Desc.Extent;
+	const FIntPoint NumTiles = GetFrameTileHashNumTiles(Extent);
+
+	FRDGBufferRef TileHashes = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), NumTiles.X * NumTiles.Y), TEXT("FrameTileHashes"));
+
+	FFrameTileHashCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FFrameTileHashCS::FParameters>();
+	PassParameters->InputTexture = Texture;
+	PassParameters->InputExtent = FUintVector2(Extent.X, Extent.Y);
+	PassParameters->NumTilesX = NumTiles.X;
+	PassParameters->RWTileHashes = GraphBuilder.CreateUAV(TileHashes);
+
+	TShaderMapRef<FFrameTileHashCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("FrameTileHash %dx%d", Extent.X, Extent.Y),
+		ComputeShader,
+		PassParameters,
+		FIntVector(NumTiles.X, NumTiles.Y, 1));
+
+	return TileHashes;
+}
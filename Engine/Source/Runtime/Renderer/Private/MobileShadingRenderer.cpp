@@ -93,13 +93,23 @@ static TAutoConsoleVariable<int32> CVarMobileCustomDepthForTranslucency(
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 
 #pragma region Das
-//强制开启Mobile CustomDepth的控制台变量
+//Mobile Das自定义深度的渲染方式
 static TAutoConsoleVariable<int32> CVarMobileDasForceCustomDepthOn(
 	TEXT("r.Mobile.DasForceCustomDepthOn"),
 	0,
-	TEXT("Force enable custom depth rendering on mobile platform. \n")
-	TEXT(" 0 = Off [default] \n")
-	TEXT(" 1 = On - Force enable custom depth rendering"),
+	TEXT("Controls when custom depth is rendered for Das pick / outline on mobile platform. \n")
+	TEXT(" 0 = On demand [default] - only on frames where a Das custom depth consumer is registered or a frame was requested \n")
+	TEXT(" 1 = On - Force enable custom depth rendering every frame"),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+//Das结果图不需要自定义深度回写时，深度模板缓冲保留在tile内存
+static TAutoConsoleVariable<int32> CVarMobileDasMemorylessCustomDepth(
+	TEXT("r.Mobile.DasMemorylessCustomDepth"),
+	1,
+	TEXT("Keep the custom depth-stencil target in tile memory (memoryless) when no material samples CustomDepth / CustomStencil,\n")
+	TEXT("so only the Das outputs are written back to system memory. Only applies to single view families. \n")
+	TEXT(" 0 = Off \n")
+	TEXT(" 1 = On [default]"),
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 #pragma endregion
 
@@ -598,8 +608,19 @@ void FMobileSceneRenderer::InitViews(
 	}
 
 #pragma region Das
-	//强制打开Android的自定义深度
-	if (CVarMobileDasForceCustomDepthOn.GetValueOnAnyThread() != 0)
+	// Only Das forces custom depth below: no material samples the depth-stencil target, so it can stay in tile memory.
+	// Each view renders its own pass and loads the previous view's depth, so this only holds for a single view.
+	SceneTexturesConfig.bMemorylessCustomDepth = !bShouldRenderCustomDepth
+		&& Views.Num() == 1
+		&& CVarMobileDasMemorylessCustomDepth.GetValueOnRenderThread() != 0;
+#pragma endregion
+
+#pragma region Das
+	//强制打开Android的自定义深度，或者仅在拾取/描边需要的帧打开
+	//一次性请求只由主视图族消费，场景捕获和反射不能把它吃掉
+	const bool bDasMainViewFamily = !Views[0].bIsSceneCapture && !Views[0].bIsReflectionCapture && !Views[0].bIsPlanarReflection;
+	const bool bDasCustomDepthDemanded = bDasMainViewFamily && ConsumeDasCustomDepthDemand();
+	if (CVarMobileDasForceCustomDepthOn.GetValueOnAnyThread() != 0 || bDasCustomDepthDemanded)
 	{
 		bShouldRenderCustomDepth = true;
 	}
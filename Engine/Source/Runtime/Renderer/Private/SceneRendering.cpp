@@ -86,6 +86,7 @@
 #include "RenderCounters.h"
 #include "RenderCore.h"
 #include "SkyAtmosphereRendering.h"
+#include "CustomDepthRendering.h"
 #include "VolumetricCloudRendering.h"
 #include "VolumetricFog.h"
 #include "PrimitiveSceneShaderData.h"
@@ -376,6 +377,14 @@ static TAutoConsoleVariable<float> CVarTranslucencyAutoBeforeDOF(
 	TEXT("Automatically bin After DOF translucency before DOF if behind focus distance (Experimental)"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<int32> CVarClampInternalBufferToMaxTextureSize(
+	TEXT("r.ClampInternalBufferToMaxTextureSize"),
+	1,
+	TEXT("Whether to lower the resolution fraction when the views of a family would need scene textures larger than the GPU's max texture dimension, upscaling them instead of failing to allocate.\n")
+	TEXT("Oversized windows (-DisableWindowSizeLimit) rely on this unless they are split into one view family per tile. The fraction does not go below the minimum screen percentage,\n")
+	TEXT("and families with the ScreenPercentage show flag disabled are not clamped, both log an error instead."),
+	ECVF_RenderThreadSafe);
+
 
 static FParallelCommandListSet* GOutstandingParallelCommandListSet = nullptr;
 
@@ -2757,6 +2766,43 @@ FIntPoint FSceneRenderer::QuantizeViewRectMin(const FIntPoint& ViewRectMin)
 	return Out;
 }
 
+/** Largest scene texture extent the views of a family may need, leaving room for view rect and buffer size quantization rounding up. */
+static int32 GetMaxInternalBufferExtent()
+{
+	return int32(GetMax2DTextureDimension()) - 16;
+}
+
+/** Extent of the unscaled views of the family once they are moved to the top left corner of the buffers. */
+static int32 GetUnconstrainedViewsExtent(const FSceneViewFamily& ViewFamily)
+{
+	FIntPoint ViewsMin(MAX_int32, MAX_int32);
+	FIntPoint ViewsMax(MIN_int32, MIN_int32);
+	for (const FSceneView* View : ViewFamily.Views)
+	{
+		ViewsMin = ViewsMin.ComponentMin(View->UnconstrainedViewRect.Min);
+		ViewsMax = ViewsMax.ComponentMax(View->UnconstrainedViewRect.Max);
+	}
+	return FMath::Max((ViewsMax - ViewsMin).GetMax(), 1);
+}
+
+/**
+ * Largest primary resolution fraction at which the views of the family still fit in a texture of the GPU's max dimension,
+ * no lower than the minimum resolution fraction. Families that must render at a fraction of 1 are not clamped.
+ */
+static float GetMaxTextureSizeResolutionFraction(const FSceneViewFamily& ViewFamily)
+{
+	if (!CVarClampInternalBufferToMaxTextureSize.GetValueOnAnyThread() || !ViewFamily.EngineShowFlags.ScreenPercentage)
+	{
+		return ISceneViewFamilyScreenPercentage::kMaxResolutionFraction;
+	}
+
+	const int32 MaxTextureSize = GetMaxInternalBufferExtent();
+	const int32 ViewsExtent = GetUnconstrainedViewsExtent(ViewFamily);
+	const float SecondaryViewFraction = FMath::Max(ViewFamily.SecondaryViewFraction, UE_SMALL_NUMBER);
+	const float FitResolutionFraction = float(MaxTextureSize) / (float(ViewsExtent) * SecondaryViewFraction);
+	return FMath::Max(FitResolutionFraction, ISceneViewFamilyScreenPercentage::kMinResolutionFraction);
+}
+
 // static
 FIntPoint FSceneRenderer::GetDesiredInternalBufferSize(const FSceneViewFamily& ViewFamily)
 {
@@ -2781,11 +2827,12 @@ FIntPoint FSceneRenderer::GetDesiredInternalBufferSize(const FSceneViewFamily& V
 	if (ISceneViewFamilyScreenPercentage const* ScreenPercentageInterface = ViewFamily.GetScreenPercentageInterface())
 	{
 		DynamicRenderScaling::TMap<float> DynamicResolutionUpperBounds = ScreenPercentageInterface->GetResolutionFractionsUpperBound();
-		const float PrimaryResolutionFractionUpperBound = DynamicResolutionUpperBounds[GDynamicPrimaryResolutionFraction];
+		const float PrimaryResolutionFractionUpperBound = FMath::Min(DynamicResolutionUpperBounds[GDynamicPrimaryResolutionFraction], GetMaxTextureSizeResolutionFraction(ViewFamily));
 		ResolutionFractionUpperBound = PrimaryResolutionFractionUpperBound * ViewFamily.SecondaryViewFraction;
 	}
 
 	FIntPoint FamilySizeUpperBound(0, 0);
+	FIntPoint TopLeftShift(MAX_int32, MAX_int32);
 
 	for (const FSceneView* View : ViewFamily.Views)
 	{
@@ -2796,8 +2843,13 @@ FIntPoint FSceneRenderer::GetDesiredInternalBufferSize(const FSceneViewFamily& V
 
 		FamilySizeUpperBound.X = FMath::Max(FamilySizeUpperBound.X, ViewRectMin.X + ViewSize.X);
 		FamilySizeUpperBound.Y = FMath::Max(FamilySizeUpperBound.Y, ViewRectMin.Y + ViewSize.Y);
+		TopLeftShift = TopLeftShift.ComponentMin(ViewRectMin);
 	}
 
+	// PrepareViewRectsForRendering() moves the views to the top left corner of the buffers, so a family covering only a tile of a
+	// large render target needs buffers the size of the tile, not of everything up to the tile.
+	FamilySizeUpperBound -= TopLeftShift;
+
 	check(FamilySizeUpperBound.GetMin() > 0);
 
 	FIntPoint DesiredBufferSize;
@@ -2935,6 +2987,23 @@ void FSceneRenderer::PrepareViewRectsForRendering(FRHICommandListImmediate& RHIC
 
 	float PrimaryResolutionFraction = DynamicResolutionFractions[GDynamicPrimaryResolutionFraction];
 	{
+		// 先按最大纹理尺寸限制，下面的检查针对的是实际渲染的比例
+		const float MaxTextureSizeResolutionFraction = GetMaxTextureSizeResolutionFraction(ViewFamily);
+		if (PrimaryResolutionFraction > MaxTextureSizeResolutionFraction)
+		{
+			PrimaryResolutionFraction = MaxTextureSizeResolutionFraction;
+			DynamicResolutionFractions[GDynamicPrimaryResolutionFraction] = PrimaryResolutionFraction;
+		}
+
+		static bool bLoggedTooLarge = false;
+		if (!bLoggedTooLarge && CVarClampInternalBufferToMaxTextureSize.GetValueOnRenderThread()
+			&& float(GetUnconstrainedViewsExtent(ViewFamily)) * PrimaryResolutionFraction * ViewFamily.SecondaryViewFraction > float(GetMaxInternalBufferExtent()))
+		{
+			UE_LOG(LogRenderer, Error, TEXT("The views of the family need scene textures larger than the max texture dimension %u even with r.ClampInternalBufferToMaxTextureSize, %s. Split the family into tiles."),
+				GetMax2DTextureDimension(), ViewFamily.EngineShowFlags.ScreenPercentage ? TEXT("the minimum resolution fraction is reached") : TEXT("the ScreenPercentage show flag is disabled"));
+			bLoggedTooLarge = true;
+		}
+
 		// Ensure screen percentage show flag is respected. Prefer to check() rather rendering at a differen screen percentage
 		// to make sure the renderer does not lie how a frame as been rendering to a dynamic resolution heuristic.
 		if (!ViewFamily.EngineShowFlags.ScreenPercentage)
@@ -3384,10 +3453,116 @@ FSceneRenderer::~FSceneRenderer()
 /** 
 * Finishes the view family rendering.
 */
+//add Das 按需渲染(r.RenderOnDemand)下，画面里有WPO动画或强制输出速度的图元时每帧都算场景变化，不进入空闲
+//移动、骨骼姿势和Das值变化由代理自己通知，这里不管
+static void NotifyRenderOnDemandDynamicContent(const FScene* Scene, TConstArrayView<FViewInfo> Views)
+{
+	static const TConsoleVariableData<int32>* CVarRenderOnDemand = IConsoleManager::Get().FindTConsoleVariableDataInt(TEXT("r.RenderOnDemand"));
+	if (!Scene || !CVarRenderOnDemand || CVarRenderOnDemand->GetValueOnRenderThread() == 0)
+	{
+		return;
+	}
+
+	// 只看每帧都在动的代理，不遍历所有可见图元
+	const bool bAnimatedVisible = FPrimitiveSceneProxy::AnyAlwaysAnimatedProxy([Scene, Views](const FPrimitiveSceneProxy& Proxy)
+	{
+		const FPrimitiveSceneInfo* PrimitiveSceneInfo = Proxy.GetPrimitiveSceneInfo();
+		if (!PrimitiveSceneInfo || PrimitiveSceneInfo->Scene != Scene || !Proxy.AlwaysHasVelocity())
+		{
+			return false;
+		}
+
+		const int32 PrimitiveIndex = PrimitiveSceneInfo->GetIndex();
+		for (const FViewInfo& View : Views)
+		{
+			if (View.PrimitiveVisibilityMap.IsValidIndex(PrimitiveIndex) && View.PrimitiveVisibilityMap[PrimitiveIndex])
+			{
+				return true;
+			}
+		}
+		return false;
+	});
+
+	if (bAnimatedVisible)
+	{
+		FPrimitiveSceneProxy::NotifySceneChanged();
+	}
+}
+
+//add Das 按渲染目标保存的Das图，只给有使用者(推流视口、DasBenchmark等)的渲染目标提取，渲染线程
+struct FDasTextureExtractsEntry
+{
+	// 提取目标的地址在图执行前不能变
+	TUniquePtr<FDasTextureExtracts> Extracts = MakeUnique<FDasTextureExtracts>();
+	int32 NumUsers = 0;
+};
+static TMap<const FRenderTarget*, FDasTextureExtractsEntry> GDasTextureExtracts;
+
+void AddDasTextureExtractsUser(const FRenderTarget* RenderTarget)
+{
+	check(IsInRenderingThread());
+	++GDasTextureExtracts.FindOrAdd(RenderTarget).NumUsers;
+}
+
+void RemoveDasTextureExtractsUser(const FRenderTarget* RenderTarget)
+{
+	check(IsInRenderingThread());
+	FDasTextureExtractsEntry* Entry = GDasTextureExtracts.Find(RenderTarget);
+	if (ensure(Entry) && --Entry->NumUsers == 0)
+	{
+		GDasTextureExtracts.Remove(RenderTarget);
+	}
+}
+
+const FDasTextureExtracts* GetDasTextureExtracts(const FRenderTarget* RenderTarget)
+{
+	check(IsInRenderingThread());
+	const FDasTextureExtractsEntry* Entry = GDasTextureExtracts.Find(RenderTarget);
+	return Entry && Entry->Extracts->ViewRect.Area() > 0 ? Entry->Extracts.Get() : nullptr;
+}
+
+static void QueueDasTextureExtractions(FRDGBuilder& GraphBuilder, const FSceneTextures& SceneTextures, const FSceneViewFamily& ViewFamily, TConstArrayView<FViewInfo> Views)
+{
+	const FDasTextureExtractsEntry* Entry = GDasTextureExtracts.Find(ViewFamily.RenderTarget);
+	if (Entry == nullptr)
+	{
+		return;
+	}
+
+	FDasTextureExtracts& Extracts = *Entry->Extracts;
+	Extracts = FDasTextureExtracts();
+
+	// 移动端tile内存里的自定义深度没有内容可提取
+	const auto ExtractIfProduced = [&GraphBuilder](FRDGTextureRef Texture, TRefCountPtr<IPooledRenderTarget>& OutTarget)
+	{
+		if (HasBeenProduced(Texture) && !EnumHasAnyFlags(Texture->Desc.Flags, TexCreate_Memoryless))
+		{
+			GraphBuilder.QueueTextureExtraction(Texture, &OutTarget, ERDGResourceExtractionFlags::AllowTransient);
+		}
+	};
+	ExtractIfProduced(SceneTextures.CustomDepth.DasStencil, Extracts.DasStencil);
+	ExtractIfProduced(SceneTextures.CustomDepth.DasCustom, Extracts.DasCustom);
+
+	for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ++ViewIndex)
+	{
+		if (ViewIndex == 0)
+		{
+			Extracts.ViewRect = Views[ViewIndex].ViewRect;
+		}
+		else
+		{
+			Extracts.ViewRect.Union(Views[ViewIndex].ViewRect);
+		}
+	}
+}
+
 void FSceneRenderer::RenderFinish(FRDGBuilder& GraphBuilder, FRDGTextureRef ViewFamilyTexture)
 {
 	RDG_EVENT_SCOPE(GraphBuilder, "RenderFinish");
 
+	NotifyRenderOnDemandDynamicContent(Scene, Views);
+	QueueDasTextureExtractions(GraphBuilder, GetActiveSceneTextures(), ViewFamily, Views);
+
 #if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
 	{
 		bool bShowPrecomputedVisibilityWarning = false;
@@ -3981,10 +4156,17 @@ void FSceneRenderer::SetupMeshPass(FViewInfo& View, FExclusiveDepthStencil::Type
 				EnumAddFlags(CullingFlags, EInstanceCullingFlags::DrawOnlyVSMInvalidatingGeometry);
 			}
 
+			//add Das CustomDepth只在开启时使用HZB剔除，默认保持完整(描边需要被遮挡的部分)
+			TRefCountPtr<IPooledRenderTarget> PrevHZB = View.PrevViewInfo.HZB;
+			if (PassType == EMeshPass::CustomDepth && !IsCustomDepthOcclusionCullingEnabled())
+			{
+				PrevHZB = nullptr;
+			}
+
 			Pass.DispatchPassSetup(
 				Scene,
 				View,
-				FInstanceCullingContext(FeatureLevel, &InstanceCullingManager, ViewIds, View.PrevViewInfo.HZB, InstanceCullingMode, CullingFlags),
+				FInstanceCullingContext(FeatureLevel, &InstanceCullingManager, ViewIds, PrevHZB, InstanceCullingMode, CullingFlags),
 				PassType,
 				BasePassDepthStencilAccess,
 				MeshPassProcessor,
@@ -492,7 +492,7 @@ void FMinimalSceneTextures::InitializeViewFamily(FRDGBuilder& GraphBuilder, FVie
 	}
 
 	// Custom Depth
-	SceneTextures.CustomDepth = FCustomDepthTextures::Create(GraphBuilder, Config.Extent, Config.ShaderPlatform);
+	SceneTextures.CustomDepth = FCustomDepthTextures::Create(GraphBuilder, Config.Extent, Config.ShaderPlatform, Config.bMemorylessCustomDepth);
 
 	ViewFamily.bIsSceneTexturesInitialized = true;
 }
@@ -842,6 +842,7 @@ void SetupSceneTextureUniformParameters(
 	SceneTextureParameters.DasStencilTexture = SystemTextures.Black;
 	SceneTextureParameters.DasCustomTexture = SystemTextures.Black;
 	SceneTextureParameters.DasCustomDepthOnTexture = SystemTextures.Black;
+	SceneTextureParameters.DasHoveredId = GetDasHoveredId();
 	SceneTextureParameters.CustomStencilTexture = SystemTextures.StencilDummySRV;
 
 	if (SceneTextures)
@@ -971,6 +972,15 @@ void SetupMobileSceneTextureUniformParameters(
 	SceneTextureParameters.CustomDepthTexture = SystemTextures.Black;
 	SceneTextureParameters.CustomDepthTextureSampler = TStaticSamplerState<>::GetRHI();
 	SceneTextureParameters.CustomStencilTexture = SystemTextures.StencilDummySRV;
+	SceneTextureParameters.DasDepthTexture = SystemTextures.Black;
+	SceneTextureParameters.DasDepthTextureSampler = TStaticSamplerState<SF_Point>::GetRHI();
+	SceneTextureParameters.DasStencilTexture = SystemTextures.Black;
+	SceneTextureParameters.DasStencilTextureSampler = TStaticSamplerState<SF_Point>::GetRHI();
+	SceneTextureParameters.DasCustomTexture = SystemTextures.Black;
+	SceneTextureParameters.DasCustomTextureSampler = TStaticSamplerState<SF_Point>::GetRHI();
+	SceneTextureParameters.DasCustomDepthOnTexture = SystemTextures.Black;
+	SceneTextureParameters.DasCustomDepthOnTextureSampler = TStaticSamplerState<SF_Point>::GetRHI();
+	SceneTextureParameters.DasHoveredId = GetDasHoveredId();
 	SceneTextureParameters.SceneVelocityTexture = SystemTextures.Black;
 	SceneTextureParameters.SceneVelocityTextureSampler = TStaticSamplerState<>::GetRHI();
 	SceneTextureParameters.GBufferATexture = SystemTextures.Black;
@@ -1054,8 +1064,34 @@ void SetupMobileSceneTextureUniformParameters(
 			const FCustomDepthTextures& CustomDepthTextures = SceneTextures->CustomDepth;
 
 			bool bCustomDepthProduced = HasBeenProduced(CustomDepthTextures.Depth);
-			SceneTextureParameters.CustomDepthTexture = bCustomDepthProduced ? CustomDepthTextures.Depth : SystemTextures.DepthDummy;
-			SceneTextureParameters.CustomStencilTexture = bCustomDepthProduced ? CustomDepthTextures.Stencil : SystemTextures.StencilDummySRV;
+			// A memoryless custom depth-stencil never leaves tile memory and cannot be sampled.
+			const bool bCustomDepthSampleable = bCustomDepthProduced && !EnumHasAnyFlags(CustomDepthTextures.Depth->Desc.Flags, TexCreate_Memoryless);
+			SceneTextureParameters.CustomDepthTexture = bCustomDepthSampleable ? CustomDepthTextures.Depth : SystemTextures.DepthDummy;
+			SceneTextureParameters.CustomStencilTexture = bCustomDepthSampleable && CustomDepthTextures.Stencil ? CustomDepthTextures.Stencil : SystemTextures.StencilDummySRV;
+
+			//add das 蒙版ID按整数编码，只能点采样
+			if (bCustomDepthProduced)
+			{
+				if (HasBeenProduced(CustomDepthTextures.DasDepth))
+				{
+					SceneTextureParameters.DasDepthTexture = CustomDepthTextures.DasDepth;
+				}
+
+				if (HasBeenProduced(CustomDepthTextures.DasStencil))
+				{
+					SceneTextureParameters.DasStencilTexture = CustomDepthTextures.DasStencil;
+				}
+
+				if (HasBeenProduced(CustomDepthTextures.DasCustom))
+				{
+					SceneTextureParameters.DasCustomTexture = CustomDepthTextures.DasCustom;
+				}
+
+				if (HasBeenProduced(CustomDepthTextures.DasCustomDepthOn))
+				{
+					SceneTextureParameters.DasCustomDepthOnTexture = CustomDepthTextures.DasCustomDepthOn;
+				}
+			}
 		}
 
 		if (EnumHasAnyFlags(SetupMode, EMobileSceneTextureSetupMode::SceneVelocity))
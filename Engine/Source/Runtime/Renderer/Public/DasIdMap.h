@@ -0,0 +1,13 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphFwd.h"
+
+/**
+ * Downscales the DasStencil texture into an ID map of OutExtent cells, each holding the ID under the cell's center (IDs cannot
+ * be filtered). MaskRect is the region of DasStencil covering the frame. Returns a structured buffer holding one uint32 per
+ * cell, laid out row by row.
+ */
+extern RENDERER_API FRDGBufferRef AddDasIdMapPass(FRDGBuilder& GraphBuilder, FRDGTextureRef DasStencilTexture, FIntRect MaskRect, FIntPoint OutExtent);
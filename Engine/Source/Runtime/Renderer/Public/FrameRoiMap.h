@@ -0,0 +1,41 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphFwd.h"
+
+/** Edge length in pixels of the encoder macroblocks described by AddFrameRoiMapPass. */
+static constexpr int32 FrameRoiMapBlockSize = 16;
+
+/** Maximum number of focus points a single ROI map pass takes into account. */
+static constexpr int32 FrameRoiMapMaxFocusPoints = 4;
+
+/** Returns the number of macroblocks covering a frame of the given extent. */
+inline FIntPoint GetFrameRoiMapNumBlocks(FIntPoint Extent)
+{
+	return FIntPoint::DivideAndRoundUp(Extent, FrameRoiMapBlockSize);
+}
+
+struct FFrameRoiMapSettings
+{
+	/** Size of the encoded frame. */
+	FIntPoint FrameExtent = FIntPoint::ZeroValue;
+
+	/** Region of the DasCustom texture that covers the frame. */
+	FIntRect MaskRect;
+
+	/** QP offset of blocks covering a non-zero DasCustom value or a focus point, and of all other blocks. */
+	int32 RoiQPOffset = -6;
+	int32 BackgroundQPOffset = 2;
+
+	/** Frame pixel positions, e.g. recent picks, whose surrounding blocks count as ROI. */
+	TArray<FIntPoint, TInlineAllocator<FrameRoiMapMaxFocusPoints>> FocusPoints;
+	int32 FocusRadius = 96;
+};
+
+/**
+ * Derives a per-macroblock QP offset map from the DasCustom texture, so encoders supporting ROI spend more bits on
+ * selected and highlighted objects. Returns a structured buffer holding one int32 per block, laid out row by row.
+ */
+extern RENDERER_API FRDGBufferRef AddFrameRoiMapPass(FRDGBuilder& GraphBuilder, FRDGTextureRef DasCustomTexture, const FFrameRoiMapSettings& Settings);
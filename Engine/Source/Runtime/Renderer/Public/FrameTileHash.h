@@ -0,0 +1,21 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphFwd.h"
+
+/** Edge length in pixels of the tiles hashed by AddFrameTileHashPass. */
+static constexpr int32 FrameTileHashTileSize = 32;
+
+/** Returns the number of hash tiles covering a texture of the given extent. */
+inline FIntPoint GetFrameTileHashNumTiles(FIntPoint Extent)
+{
+	return FIntPoint::DivideAndRoundUp(Extent, FrameTileHashTileSize);
+}
+
+/**
+ * Hashes Texture in FrameTileHashTileSize tiles. Returns a structured buffer holding one uint32 per tile, laid out row by row.
+ * Comparing the hashes of two frames tells which regions changed without reading back the frames themselves.
+ */
+extern RENDERER_API FRDGBufferRef AddFrameTileHashPass(FRDGBuilder& GraphBuilder, FRDGTextureRef Texture);
@@ -9,6 +9,7 @@
 #include "SceneTexturesConfig.h"
 
 class FRDGBuilder;
+class FRenderTarget;
 struct FSceneTextures;
 
 enum class ESceneTexture
@@ -206,6 +207,27 @@ private:
 /** Returns the global scene texture extracts struct. */
 const RENDERER_API FSceneTextureExtracts& GetSceneTextureExtracts();
 
+//add Das
+/** Das textures of the last scene render into one render target. Unlike GetSceneTextureExtracts() they are not overwritten by other view families. */
+struct FDasTextureExtracts
+{
+	TRefCountPtr<IPooledRenderTarget> DasStencil;
+	TRefCountPtr<IPooledRenderTarget> DasCustom;
+
+	/** Union of the family's view rects, the region of the Das textures that covers the render target. */
+	FIntRect ViewRect;
+
+	FRHITexture* GetDasStencil() const { return DasStencil ? DasStencil->GetRHI() : nullptr; }
+	FRHITexture* GetDasCustom() const { return DasCustom ? DasCustom->GetRHI() : nullptr; }
+};
+
+/** Extracts the Das textures of scene renders into the render target, e.g. a streamed viewport, until every user removed itself. Render thread. */
+RENDERER_API void AddDasTextureExtractsUser(const FRenderTarget* RenderTarget);
+RENDERER_API void RemoveDasTextureExtractsUser(const FRenderTarget* RenderTarget);
+
+/** Das textures of the last scene render into the render target, null if it has no user or has not been rendered yet. Render thread. */
+RENDERER_API const FDasTextureExtracts* GetDasTextureExtracts(const FRenderTarget* RenderTarget);
+
 /** Pass through to View.GetSceneTexturesConfig().Extent, useful in headers where the FViewInfo structure isn't exposed. */
 extern RENDERER_API FIntPoint GetSceneTextureExtentFromView(const FViewInfo& View);
 
@@ -227,6 +249,15 @@ enum class DasCustomRenderModel : uint32
 
 RENDERER_API DasCustomRenderModel GetDasCustomRenderModel();
 RENDERER_API void SetDasCustomRenderModel(DasCustomRenderModel nmodel);
+
+//Mobile按需渲染自定义深度：有描边/高亮等持续使用者注册时每帧渲染
+RENDERER_API void AddDasCustomDepthConsumer();
+RENDERER_API void RemoveDasCustomDepthConsumer();
+//拾取等一次性使用者，只请求下一帧渲染自定义深度
+RENDERER_API void RequestDasCustomDepthFrame();
+//悬停高亮：与DasStencil结果图比较的ID(DasStencil + BatchID)，0为无。只写入场景纹理uniform，不更新场景；值变化时通知按需渲染重绘
+RENDERER_API void SetDasHoveredId(uint32 nId);
+RENDERER_API uint32 GetDasHoveredId();
 //Das+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
 
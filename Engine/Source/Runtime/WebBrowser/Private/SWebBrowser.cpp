@@ -129,6 +129,7 @@ void SWebBrowser::Construct(const FArguments& InArgs, const TSharedPtr<IWebBrows
 				.OnDragWindow(InArgs._OnDragWindow)
 				.OnConsoleMessage(OnConsoleMessage)
 				.BrowserFrameRate(InArgs._BrowserFrameRate)
+				.UseBrowserWindowPool(InArgs._UseBrowserWindowPool)
 			]
 			+ SOverlay::Slot()
 			.HAlign(HAlign_Center)
@@ -397,5 +398,15 @@ void SWebBrowser::SetParentWindow(TSharedPtr<SWindow> Window)
 	}
 }
 
+#pragma region Das
+void SWebBrowser::SetIsOccluded(bool bOccluded)
+{
+	if (BrowserView.IsValid())
+	{
+		BrowserView->SetIsOccluded(bOccluded);
+	}
+}
+#pragma endregion
+
 
 #undef LOCTEXT_NAMESPACE
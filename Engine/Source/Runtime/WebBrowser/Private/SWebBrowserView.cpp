@@ -4,6 +4,7 @@
 #include "Misc/CommandLine.h"
 #include "Misc/ConfigCacheIni.h"
 #include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
 #include "WebBrowserModule.h"
 #include "Layout/WidgetPath.h"
 #include "Framework/Application/MenuStack.h"
@@ -12,6 +13,10 @@
 #include "IWebBrowserWindow.h"
 #include "WebBrowserViewport.h"
 #include "IWebBrowserAdapter.h"
+#include "WebBrowserDataChannel.h"
+#include "WebBrowserDirtyRects.h"
+#include "WebBrowserWindowPool.h"
+#include "WebBrowserLog.h"
 
 #if PLATFORM_ANDROID && USE_ANDROID_JNI
 #	include "Android/AndroidWebBrowserWindow.h"
@@ -27,6 +32,30 @@
 
 #define LOCTEXT_NAMESPACE "WebBrowser"
 
+static bool GWebBrowserSuspendHiddenViews = true;
+static FAutoConsoleVariableRef CVarWebBrowserSuspendHiddenViews(
+	TEXT("r.WebBrowser.SuspendHiddenViews"),
+	GWebBrowserSuspendHiddenViews,
+	TEXT("If true, a browser view that is collapsed, clipped out, in an inactive switcher slot, in a minimized window or marked occluded stops off-screen rendering until it is painted again."),
+	ECVF_Default
+	);
+
+static float GWebBrowserSuspendHiddenDelay = 0.5f;
+static FAutoConsoleVariableRef CVarWebBrowserSuspendHiddenDelay(
+	TEXT("r.WebBrowser.SuspendHiddenDelay"),
+	GWebBrowserSuspendHiddenDelay,
+	TEXT("Seconds a browser view has to go unpainted before its off-screen rendering is suspended."),
+	ECVF_Default
+	);
+
+static int32 GWebBrowserMaxFrameRate = 0;
+static FAutoConsoleVariableRef CVarWebBrowserMaxFrameRate(
+	TEXT("r.WebBrowser.MaxFrameRate"),
+	GWebBrowserMaxFrameRate,
+	TEXT("Caps the BrowserFrameRate of browser views created afterwards. 0 keeps the per-view rate."),
+	ECVF_Default
+	);
+
 SWebBrowserView::SWebBrowserView()
 {
 }
@@ -37,6 +66,9 @@ SWebBrowserView::~SWebBrowserView()
 	{
 		BrowserWindow->OnDocumentStateChanged().RemoveAll(this);
 		BrowserWindow->OnNeedsRedraw().RemoveAll(this);
+#if !defined(DUMMY_WEB_BROWSER) && WITH_CEF3
+		static_cast<FWebBrowserWindow*>(BrowserWindow.Get())->OnPaintBuffer().Unbind();
+#endif
 		BrowserWindow->OnTitleChanged().RemoveAll(this);
 		BrowserWindow->OnUrlChanged().RemoveAll(this);
 		BrowserWindow->OnToolTip().RemoveAll(this);
@@ -65,6 +97,11 @@ SWebBrowserView::~SWebBrowserView()
 		{
 			BrowserWindow->OnBeforePopup().Unbind();
 		}
+
+		if (bUsesPooledWindow)
+		{
+			FWebBrowserWindowPool::Get().Release(BrowserWindow);
+		}
 	}
 
 	TSharedPtr<SWindow> SlateParentWindow = SlateParentWindowPtr.Pin();
@@ -117,12 +154,17 @@ void SWebBrowserView::Construct(const FArguments& InArgs, const TSharedPtr<IWebB
 			Settings.ContentsToLoad = InArgs._ContentsToLoad;
 			Settings.bShowErrorMessage = InArgs._ShowErrorMessage;
 			Settings.BackgroundColor = InArgs._BackgroundColor;
-			Settings.BrowserFrameRate = InArgs._BrowserFrameRate;
+			Settings.BrowserFrameRate = GWebBrowserMaxFrameRate > 0 ? FMath::Min(InArgs._BrowserFrameRate, GWebBrowserMaxFrameRate) : InArgs._BrowserFrameRate;
 			Settings.Context = InArgs._ContextSettings;
 			Settings.AltRetryDomains = InArgs._AltRetryDomains;
 
+			if (InArgs._UseBrowserWindowPool)
+			{
+				BrowserWindow = FWebBrowserWindowPool::Get().Acquire(Settings);
+				bUsesPooledWindow = BrowserWindow.IsValid();
+			}
 			// IWebBrowserModule::Get() was already callled in WebBrowserWidgetModule.cpp so we don't need to force the load again here
-			if (IWebBrowserModule::IsAvailable() && IWebBrowserModule::Get().IsWebModuleAvailable())
+			else if (IWebBrowserModule::IsAvailable() && IWebBrowserModule::Get().IsWebModuleAvailable())
 			{
 				BrowserWindow = IWebBrowserModule::Get().GetSingleton()->CreateBrowserWindow(Settings);
 			}
@@ -155,6 +197,10 @@ void SWebBrowserView::Construct(const FArguments& InArgs, const TSharedPtr<IWebB
 
 		BrowserWindow->OnDocumentStateChanged().AddSP(this, &SWebBrowserView::HandleBrowserWindowDocumentStateChanged);
 		BrowserWindow->OnNeedsRedraw().AddSP(this, &SWebBrowserView::HandleBrowserWindowNeedsRedraw);
+#if !defined(DUMMY_WEB_BROWSER) && WITH_CEF3
+		// CEF的OnPaint把缓冲和脏矩形交给视图，只上传变化的区域
+		static_cast<FWebBrowserWindow*>(BrowserWindow.Get())->OnPaintBuffer().BindSP(this, &SWebBrowserView::HandleBrowserWindowPaint);
+#endif
 		BrowserWindow->OnTitleChanged().AddSP(this, &SWebBrowserView::HandleTitleChanged);
 		BrowserWindow->OnUrlChanged().AddSP(this, &SWebBrowserView::HandleUrlChanged);
 		BrowserWindow->OnToolTip().AddSP(this, &SWebBrowserView::HandleToolTip);
@@ -172,10 +218,18 @@ void SWebBrowserView::Construct(const FArguments& InArgs, const TSharedPtr<IWebB
 		if (!BrowserWindow->OnLoadUrl().IsBound())
 		{
 			BrowserWindow->OnLoadUrl().BindSP(this, &SWebBrowserView::HandleLoadUrl);
+
+			// 在这里一次性创建，HandleLoadUrl在IO线程读取，之后不再赋值
+			DataChannel = MakeShared<FWebBrowserDataChannel>(BrowserWindow.ToSharedRef());
+			if (BrowserWindow->GetDocumentLoadingState() == EWebBrowserDocumentState::Completed)
+			{
+				DataChannel->OnDocumentReady();
+			}
 		}
 		else
 		{
 			check(!OnLoadUrl.IsBound());
+			UE_LOG(LogWebBrowser, Warning, TEXT("Browser window load requests are already handled elsewhere, this view has no data channel and does not serve web resource archives"));
 		}
 
 		if (!BrowserWindow->OnBeforePopup().IsBound())
@@ -226,6 +280,11 @@ void SWebBrowserView::Construct(const FArguments& InArgs, const TSharedPtr<IWebB
 #endif
 		// If we could not obtain the parent window during widget construction, we'll defer and keep trying.
 		SetupParentWindowHandlers();
+
+		// 隐藏检测依赖OnPaint，失效面板里缓存的绘制不会调用OnPaint，所以开启时强制每帧绘制
+		ForceVolatile(GWebBrowserSuspendHiddenViews);
+		LastVisiblePaintTime = FSlateApplication::Get().GetCurrentTime();
+		SuspensionTimerHandle = RegisterActiveTimer(0.25f, FWidgetActiveTimerDelegate::CreateSP(this, &SWebBrowserView::UpdateRenderingSuspension));
 	}
 	else
 	{
@@ -242,6 +301,16 @@ int32 SWebBrowserView::OnPaint(const FPaintArgs& Args, const FGeometry& Allotted
 	}
 
 	int32 Layer = SCompoundWidget::OnPaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
+
+	// Collapsed views, inactive switcher slots and minimized windows are not painted at all, clipped out views are painted outside their culling rect.
+	if (MyCullingRect.IntersectionWith(AllottedGeometry.GetRenderBoundingRect()).GetArea() > 0.0f)
+	{
+		LastVisiblePaintTime = FSlateApplication::Get().GetCurrentTime();
+		if (bRenderingSuspended && !bIsOccluded)
+		{
+			bResumeRenderingRequested = true;
+		}
+	}
 	
 	// Cache a reference to our parent window, if we didn't already reference it.
 	if (!SlateParentWindowPtr.IsValid())
@@ -436,6 +505,11 @@ void SWebBrowserView::HandleBrowserWindowDocumentStateChanged(EWebBrowserDocumen
 				}
 			}
 
+			if (DataChannel.IsValid())
+			{
+				DataChannel->OnDocumentReady();
+			}
+
 			OnLoadCompleted.ExecuteIfBound();
 		}
 		break;
@@ -445,6 +519,11 @@ void SWebBrowserView::HandleBrowserWindowDocumentStateChanged(EWebBrowserDocumen
 		break;
 
 	case EWebBrowserDocumentState::Loading:
+		// 新页面收不到旧页面的批次，也不会确认
+		if (DataChannel.IsValid())
+		{
+			DataChannel->Reset();
+		}
 		OnLoadStarted.ExecuteIfBound();
 		break;
 	}
@@ -459,6 +538,11 @@ void SWebBrowserView::HandleBrowserWindowNeedsRedraw()
 	}
 }
 
+void SWebBrowserView::HandleBrowserWindowPaint(FSlateUpdatableTexture* Texture, uint32 Width, uint32 Height, const void* Buffer, const TArray<FIntRect>& DirtyRects)
+{
+	FWebBrowserDirtyRects::Upload(Texture, Width, Height, Buffer, DirtyRects);
+}
+
 void SWebBrowserView::HandleTitleChanged( FString NewTitle )
 {
 	const FText NewTitleText = FText::FromString(NewTitle);
@@ -506,6 +590,11 @@ bool SWebBrowserView::HandleBeforeNavigation(const FString& Url, const FWebNavig
 
 bool SWebBrowserView::HandleLoadUrl(const FString& Method, const FString& Url, FString& OutResponse)
 {
+	if (DataChannel.IsValid() && DataChannel->HandleLoadUrl(Method, Url, OutResponse))
+	{
+		return true;
+	}
+
 	if(OnLoadUrl.IsBound())
 	{
 		return OnLoadUrl.Execute(Method, Url, OutResponse);
@@ -762,6 +851,70 @@ TSharedPtr<IWebBrowserWindow> SWebBrowserView::GetBrowserWindow()
 {
 	return BrowserWindow;
 }
+
+TSharedPtr<FWebBrowserDataChannel> SWebBrowserView::GetDataChannel()
+{
+	return DataChannel;
+}
+
+void SWebBrowserView::Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime)
+{
+	SCompoundWidget::Tick(AllottedGeometry, InCurrentTime, InDeltaTime);
+
+	// OnPaint是const，只记下可见绘制，在这里恢复
+	if (bRenderingSuspended && !bIsOccluded && (bResumeRenderingRequested || !GWebBrowserSuspendHiddenViews))
+	{
+		SetRenderingSuspended(false);
+	}
+	bResumeRenderingRequested = false;
+}
+
+void SWebBrowserView::SetIsOccluded(bool bOccluded)
+{
+	bIsOccluded = bOccluded;
+	if (bOccluded && GWebBrowserSuspendHiddenViews)
+	{
+		SetRenderingSuspended(true);
+	}
+	// 取消遮挡后等下次绘制恢复，此时不一定在屏幕上
+}
+
+EActiveTimerReturnType SWebBrowserView::UpdateRenderingSuspension(double InCurrentTime, float InDeltaTime)
+{
+	// 控制台变量可能在运行时切换
+	ForceVolatile(GWebBrowserSuspendHiddenViews);
+	if (!GWebBrowserSuspendHiddenViews)
+	{
+		SetRenderingSuspended(false);
+		return EActiveTimerReturnType::Continue;
+	}
+
+	// While Slate sleeps nothing is painted, visible views included.
+	const bool bSlateAsleep = FSlateApplication::Get().IsSlateAsleep();
+	if (bIsOccluded || (!bSlateAsleep && InCurrentTime - LastVisiblePaintTime > GWebBrowserSuspendHiddenDelay))
+	{
+		SetRenderingSuspended(true);
+
+		// 挂起后由OnPaint标记、Tick恢复，不再需要定时检查
+		SuspensionTimerHandle.Reset();
+		return EActiveTimerReturnType::Stop;
+	}
+	return EActiveTimerReturnType::Continue;
+}
+
+void SWebBrowserView::SetRenderingSuspended(bool bSuspended)
+{
+	if (bRenderingSuspended != bSuspended && BrowserWindow.IsValid())
+	{
+		bRenderingSuspended = bSuspended;
+		BrowserWindow->SetIsHidden(bSuspended);
+	}
+
+	if (!bSuspended && !SuspensionTimerHandle.IsValid())
+	{
+		SuspensionTimerHandle = RegisterActiveTimer(0.25f, FWidgetActiveTimerDelegate::CreateSP(this, &SWebBrowserView::UpdateRenderingSuspension));
+	}
+}
 #pragma endregion
 
 #undef LOCTEXT_NAMESPACE
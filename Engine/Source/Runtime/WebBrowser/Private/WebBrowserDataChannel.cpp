@@ -0,0 +1,223 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WebBrowserDataChannel.h"
+#include "IWebBrowserWindow.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Base64.h"
+#include "WebBrowserDirtyRects.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Data Channel Bytes Sent"), STAT_WebBrowserDataChannelBytesSent, STATGROUP_WebBrowser);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Data Channel Entries Sent"), STAT_WebBrowserDataChannelEntriesSent, STATGROUP_WebBrowser);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Data Channel Entries Coalesced"), STAT_WebBrowserDataChannelEntriesCoalesced, STATGROUP_WebBrowser);
+
+static int32 GWebBrowserDataChannelMaxInFlight = 2;
+static FAutoConsoleVariableRef CVarWebBrowserDataChannelMaxInFlight(
+	TEXT("r.WebBrowser.DataChannel.MaxInFlight"),
+	GWebBrowserDataChannelMaxInFlight,
+	TEXT("Batches a page may leave unacknowledged before the data channel stops sending and keeps coalescing updates."),
+	ECVF_Default
+	);
+
+static int32 GWebBrowserDataChannelMaxBatchKB = 4096;
+static FAutoConsoleVariableRef CVarWebBrowserDataChannelMaxBatchKB(
+	TEXT("r.WebBrowser.DataChannel.MaxBatchKB"),
+	GWebBrowserDataChannelMaxBatchKB,
+	TEXT("Size limit of one data channel batch, entries beyond it wait for the next frame. A single larger entry is still sent on its own."),
+	ECVF_Default
+	);
+
+static float GWebBrowserDataChannelAckTimeout = 2.0f;
+static FAutoConsoleVariableRef CVarWebBrowserDataChannelAckTimeout(
+	TEXT("r.WebBrowser.DataChannel.AckTimeout"),
+	GWebBrowserDataChannelAckTimeout,
+	TEXT("Seconds after which an unacknowledged batch is considered lost, so a reloaded or stuck page does not stall the channel."),
+	ECVF_Default
+	);
+
+/** Requests to this origin never reach the network, the channel answers them from HandleLoadUrl. */
+static const TCHAR* DataChannelUrl = TEXT("https://ue-channel.localhost/");
+
+/**
+ * Page side of the channel. A batch is a little endian uint32 entry count followed by, per entry, a uint16 key length,
+ * the UTF-8 key, a uint32 payload length and the payload. Messages to C++ are one entry without the count, base64url in the query.
+ */
+static const TCHAR* DataChannelScript = TEXT(
+	"if(!window.ueChannel){window.ueChannel={_l:[],_u:'https://ue-channel.localhost/',"
+	"onMessage:function(f){this._l.push(f);},"
+	"_b64:function(u){var s='';for(var i=0;i<u.length;i+=32768)s+=String.fromCharCode.apply(null,u.subarray(i,i+32768));return btoa(s).replace(/\\+/g,'-').replace(/\\//g,'_');},"
+	"_receive:function(q,b){var s=atob(b),u=new Uint8Array(s.length);for(var i=0;i<s.length;i++)u[i]=s.charCodeAt(i);"
+	"var v=new DataView(u.buffer),o=4,c=v.getUint32(0,true),d=new TextDecoder();"
+	"try{for(var n=0;n<c;n++){var kl=v.getUint16(o,true);o+=2;var k=d.decode(u.subarray(o,o+kl));o+=kl;var pl=v.getUint32(o,true);o+=4;var p=u.buffer.slice(o,o+pl);o+=pl;"
+	"for(var j=0;j<this._l.length;j++)this._l[j](k,p);}}"
+	"finally{fetch(this._u+'ack?q='+q,{mode:'no-cors'});}},"
+	"send:function(k,b){var e=new TextEncoder().encode(k),p=new Uint8Array(b),m=new Uint8Array(2+e.length+p.length);"
+	"new DataView(m.buffer).setUint16(0,e.length,true);m.set(e,2);m.set(p,2+e.length);"
+	"fetch(this._u+'message?d='+this._b64(m),{mode:'no-cors'});}};}"
+);
+
+FWebBrowserDataChannel::FWebBrowserDataChannel(const TSharedRef<IWebBrowserWindow>& InBrowserWindow)
+	: BrowserWindow(InBrowserWindow)
+{
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FWebBrowserDataChannel::Tick));
+}
+
+FWebBrowserDataChannel::~FWebBrowserDataChannel()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+}
+
+void FWebBrowserDataChannel::Post(const FString& Key, TConstArrayView<uint8> Payload)
+{
+	if (TArray<uint8>* Queued = Pending.Find(Key))
+	{
+		INC_DWORD_STAT(STAT_WebBrowserDataChannelEntriesCoalesced);
+		*Queued = Payload;
+		return;
+	}
+
+	Pending.Add(Key, TArray<uint8>(Payload));
+	PendingOrder.Add(Key);
+}
+
+bool FWebBrowserDataChannel::IsBackPressured() const
+{
+	return InFlight.Num() >= FMath::Max(GWebBrowserDataChannelMaxInFlight, 1);
+}
+
+void FWebBrowserDataChannel::Reset()
+{
+	Pending.Reset();
+	PendingOrder.Reset();
+	InFlight.Reset();
+	ReceivedAcks.Empty();
+	ReceivedMessages.Empty();
+	bDocumentReady = false;
+}
+
+void FWebBrowserDataChannel::OnDocumentReady()
+{
+	TSharedPtr<IWebBrowserWindow> Window = BrowserWindow.Pin();
+	if (Window.IsValid())
+	{
+		Window->ExecuteJavascript(DataChannelScript);
+		bDocumentReady = true;
+	}
+}
+
+bool FWebBrowserDataChannel::HandleLoadUrl(const FString& Method, const FString& Url, FString& OutResponse)
+{
+	if (!Url.StartsWith(DataChannelUrl))
+	{
+		return false;
+	}
+
+	// 可能不在游戏线程，这里只入队
+	const FString Request = Url.RightChop(FCString::Strlen(DataChannelUrl));
+	if (Request.StartsWith(TEXT("ack?q=")))
+	{
+		ReceivedAcks.Enqueue((uint32)FCString::Strtoui64(*Request.RightChop(6), nullptr, 10));
+	}
+	else if (Request.StartsWith(TEXT("message?d=")))
+	{
+		TArray<uint8> Message;
+		if (FBase64::Decode(Request.RightChop(10), Message, EBase64Mode::UrlSafe))
+		{
+			ReceivedMessages.Enqueue(MoveTemp(Message));
+		}
+	}
+
+	OutResponse.Reset();
+	return true;
+}
+
+bool FWebBrowserDataChannel::Tick(float DeltaTime)
+{
+	uint32 Sequence = 0;
+	while (ReceivedAcks.Dequeue(Sequence))
+	{
+		InFlight.Remove(Sequence);
+	}
+
+	TArray<uint8> Message;
+	while (ReceivedMessages.Dequeue(Message))
+	{
+		if (Message.Num() < 2)
+		{
+			continue;
+		}
+
+		const int32 KeyLength = Message[0] | (Message[1] << 8);
+		if (Message.Num() < 2 + KeyLength)
+		{
+			continue;
+		}
+
+		const FUTF8ToTCHAR Key(reinterpret_cast<const ANSICHAR*>(Message.GetData() + 2), KeyLength);
+		const TArray<uint8> Payload(Message.GetData() + 2 + KeyLength, Message.Num() - 2 - KeyLength);
+		MessageEvent.Broadcast(FString(Key.Length(), Key.Get()), Payload);
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	for (auto It = InFlight.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value() > GWebBrowserDataChannelAckTimeout)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (bDocumentReady && PendingOrder.Num() > 0 && !IsBackPressured())
+	{
+		SendBatch();
+	}
+	return true;
+}
+
+void FWebBrowserDataChannel::SendBatch()
+{
+	TSharedPtr<IWebBrowserWindow> Window = BrowserWindow.Pin();
+	if (!Window.IsValid())
+	{
+		Reset();
+		return;
+	}
+
+	const int64 MaxBatchBytes = int64(FMath::Max(GWebBrowserDataChannelMaxBatchKB, 1)) * 1024;
+
+	TArray<uint8> Batch;
+	Batch.AddZeroed(sizeof(uint32));
+	uint32 NumEntries = 0;
+	int32 NumSent = 0;
+	for (; NumSent < PendingOrder.Num(); ++NumSent)
+	{
+		const FString& Key = PendingOrder[NumSent];
+		const TArray<uint8>& Payload = Pending.FindChecked(Key);
+		const FTCHARToUTF8 KeyUtf8(*Key);
+		const int64 EntryBytes = sizeof(uint16) + KeyUtf8.Length() + sizeof(uint32) + Payload.Num();
+		if (NumEntries > 0 && Batch.Num() + EntryBytes > MaxBatchBytes)
+		{
+			break;
+		}
+
+		const uint16 KeyLength = (uint16)FMath::Min(KeyUtf8.Length(), (int32)MAX_uint16);
+		const uint32 PayloadLength = Payload.Num();
+		Batch.Append(reinterpret_cast<const uint8*>(&KeyLength), sizeof(KeyLength));
+		Batch.Append(reinterpret_cast<const uint8*>(KeyUtf8.Get()), KeyLength);
+		Batch.Append(reinterpret_cast<const uint8*>(&PayloadLength), sizeof(PayloadLength));
+		Batch.Append(Payload);
+		++NumEntries;
+
+		Pending.Remove(Key);
+	}
+	PendingOrder.RemoveAt(0, NumSent, false);
+	FMemory::Memcpy(Batch.GetData(), &NumEntries, sizeof(NumEntries));
+
+	const uint32 Sequence = NextSequence++;
+	InFlight.Add(Sequence, FPlatformTime::Seconds());
+
+	// 整批只有一次脚本执行，页面端脚本在文档加载完成时已注入
+	Window->ExecuteJavascript(FString::Printf(TEXT("window.ueChannel._receive(%u,'%s');"), Sequence, *FBase64::Encode(Batch)));
+
+	INC_DWORD_STAT_BY(STAT_WebBrowserDataChannelBytesSent, Batch.Num());
+	INC_DWORD_STAT_BY(STAT_WebBrowserDataChannelEntriesSent, NumEntries);
+}
@@ -0,0 +1,177 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WebBrowserDirtyRects.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Textures/SlateShaderResource.h"
+#include "Textures/SlateUpdatableTexture.h"
+#include "RenderingThread.h"
+#include "RHICommandList.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Uploaded Bytes"), STAT_WebBrowserUploadedBytes, STATGROUP_WebBrowser);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Uploaded Rects"), STAT_WebBrowserUploadedRects, STATGROUP_WebBrowser);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Full Uploads"), STAT_WebBrowserFullUploads, STATGROUP_WebBrowser);
+
+CSV_DEFINE_CATEGORY(WebBrowser, true);
+
+static int32 GWebBrowserMaxDirtyRects = 8;
+static FAutoConsoleVariableRef CVarWebBrowserMaxDirtyRects(
+	TEXT("r.WebBrowser.MaxDirtyRects"),
+	GWebBrowserMaxDirtyRects,
+	TEXT("Dirty rects reported by a browser paint are merged down to this many separate texture uploads. 0 uploads the whole buffer every paint."),
+	ECVF_Default
+	);
+
+static float GWebBrowserFullUploadRatio = 0.6f;
+static FAutoConsoleVariableRef CVarWebBrowserFullUploadRatio(
+	TEXT("r.WebBrowser.FullUploadRatio"),
+	GWebBrowserFullUploadRatio,
+	TEXT("When the merged dirty rects cover more than this fraction of the browser buffer, the whole buffer is uploaded in one go."),
+	ECVF_Default
+	);
+
+static int64 GetRectArea(const FIntRect& Rect)
+{
+	return int64(Rect.Width()) * Rect.Height();
+}
+
+bool FWebBrowserDirtyRects::Coalesce(TArray<FIntRect>& InOutRects, FIntPoint BufferSize)
+{
+	const FIntRect BufferRect(FIntPoint::ZeroValue, BufferSize);
+	const int32 MaxRects = GWebBrowserMaxDirtyRects;
+	if (MaxRects <= 0 || BufferRect.IsEmpty())
+	{
+		return false;
+	}
+
+	for (int32 Index = InOutRects.Num() - 1; Index >= 0; --Index)
+	{
+		InOutRects[Index].Clip(BufferRect);
+		if (InOutRects[Index].IsEmpty())
+		{
+			InOutRects.RemoveAtSwap(Index, 1, false);
+		}
+	}
+
+	// Scrolling or a page load reports lots of rects, the pairwise merge below is quadratic so just take the bounds.
+	if (InOutRects.Num() > 64)
+	{
+		FIntRect Bounds = InOutRects[0];
+		for (const FIntRect& Rect : InOutRects)
+		{
+			Bounds.Union(Rect);
+		}
+		InOutRects.Reset();
+		InOutRects.Add(Bounds);
+	}
+
+	// Merge the pair whose bounding rect wastes the fewest pixels, overlapping and touching rects go first as they waste none.
+	while (InOutRects.Num() > 1)
+	{
+		int64 BestWaste = MAX_int64;
+		int32 BestA = INDEX_NONE;
+		int32 BestB = INDEX_NONE;
+		for (int32 A = 0; A < InOutRects.Num(); ++A)
+		{
+			for (int32 B = A + 1; B < InOutRects.Num(); ++B)
+			{
+				FIntRect Merged = InOutRects[A];
+				Merged.Union(InOutRects[B]);
+				const int64 Waste = GetRectArea(Merged) - GetRectArea(InOutRects[A]) - GetRectArea(InOutRects[B]);
+				if (Waste < BestWaste)
+				{
+					BestWaste = Waste;
+					BestA = A;
+					BestB = B;
+				}
+			}
+		}
+
+		if (BestWaste > 0 && InOutRects.Num() <= MaxRects)
+		{
+			break;
+		}
+
+		InOutRects[BestA].Union(InOutRects[BestB]);
+		InOutRects.RemoveAtSwap(BestB, 1, false);
+	}
+
+	int64 DirtyArea = 0;
+	for (const FIntRect& Rect : InOutRects)
+	{
+		DirtyArea += GetRectArea(Rect);
+	}
+	return InOutRects.Num() > 0 && DirtyArea < GetRectArea(BufferRect) * GWebBrowserFullUploadRatio;
+}
+
+void FWebBrowserDirtyRects::Upload(FSlateUpdatableTexture* Texture, uint32 Width, uint32 Height, const void* Buffer, TArray<FIntRect> DirtyRects)
+{
+	if (Texture == nullptr || Buffer == nullptr)
+	{
+		return;
+	}
+
+	// 只有RHI纹理且尺寸不变时才能局部更新，改变尺寸时必须走完整上传
+	FSlateShaderResource* Resource = Texture->GetSlateResource();
+	const bool bCanUploadRegions = Resource
+		&& Resource->GetType() == ESlateShaderResource::NativeTexture
+		&& Resource->GetWidth() == Width
+		&& Resource->GetHeight() == Height;
+
+	if (!bCanUploadRegions || !Coalesce(DirtyRects, FIntPoint(Width, Height)))
+	{
+		Texture->UpdateTextureThreadSafeRaw(Width, Height, Buffer);
+
+		const uint32 UploadedBytes = Width * Height * GPixelFormats[PF_B8G8R8A8].BlockBytes;
+		INC_DWORD_STAT_BY(STAT_WebBrowserUploadedBytes, UploadedBytes);
+		INC_DWORD_STAT(STAT_WebBrowserFullUploads);
+		CSV_CUSTOM_STAT(WebBrowser, UploadedKB, UploadedBytes / 1024.0f, ECsvCustomStatOp::Accumulate);
+		return;
+	}
+
+	// The paint buffer belongs to CEF and is only valid during the paint, so the dirty rows are packed into one staging copy.
+	const uint32 BytesPerPixel = GPixelFormats[PF_B8G8R8A8].BlockBytes;
+	const uint32 SourcePitch = Width * BytesPerPixel;
+	int64 StagingSize = 0;
+	for (const FIntRect& Rect : DirtyRects)
+	{
+		StagingSize += GetRectArea(Rect) * BytesPerPixel;
+	}
+
+	TArray<uint8> StagingData;
+	StagingData.SetNumUninitialized(StagingSize);
+	uint8* Dest = StagingData.GetData();
+	for (const FIntRect& Rect : DirtyRects)
+	{
+		const uint32 RowBytes = Rect.Width() * BytesPerPixel;
+		const uint8* Source = static_cast<const uint8*>(Buffer) + Rect.Min.Y * SourcePitch + Rect.Min.X * BytesPerPixel;
+		for (int32 Row = 0; Row < Rect.Height(); ++Row)
+		{
+			FMemory::Memcpy(Dest, Source, RowBytes);
+			Dest += RowBytes;
+			Source += SourcePitch;
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_WebBrowserUploadedBytes, StagingSize);
+	INC_DWORD_STAT_BY(STAT_WebBrowserUploadedRects, DirtyRects.Num());
+	CSV_CUSTOM_STAT(WebBrowser, UploadedKB, StagingSize / 1024.0f, ECsvCustomStatOp::Accumulate);
+
+	ENQUEUE_RENDER_COMMAND(WebBrowserUploadDirtyRects)(
+		[Resource, DirtyRects = MoveTemp(DirtyRects), StagingData = MoveTemp(StagingData), BytesPerPixel](FRHICommandListImmediate& RHICmdList)
+		{
+			FTexture2DRHIRef TextureRHI = static_cast<TSlateTexture<FTexture2DRHIRef>*>(Resource)->GetTypedResource();
+			if (!TextureRHI.IsValid())
+			{
+				return;
+			}
+
+			const uint8* Source = StagingData.GetData();
+			for (const FIntRect& Rect : DirtyRects)
+			{
+				const FUpdateTextureRegion2D Region(Rect.Min.X, Rect.Min.Y, 0, 0, Rect.Width(), Rect.Height());
+				RHICmdList.UpdateTexture2D(TextureRHI, 0, Region, Rect.Width() * BytesPerPixel, Source);
+				Source += GetRectArea(Rect) * BytesPerPixel;
+			}
+		});
+}
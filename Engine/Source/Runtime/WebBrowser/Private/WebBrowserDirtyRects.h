@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSlateUpdatableTexture;
+
+DECLARE_STATS_GROUP(TEXT("WebBrowser"), STATGROUP_WebBrowser, STATCAT_Advanced);
+
+/**
+ * Uploads only the dirty regions of an off-screen rendered browser buffer to its Slate texture.
+ * The CEF window hands every paint to SWebBrowserView::HandleBrowserWindowPaint through OnPaintBuffer, which calls Upload
+ * with the dirty rects reported by CEF instead of pushing the whole buffer, so a gauge changing on a 4K overlay costs the
+ * gauge's pixels rather than the page.
+ */
+class FWebBrowserDirtyRects
+{
+public:
+	/**
+	 * Clamps the rects to the buffer and merges them until at most r.WebBrowser.MaxDirtyRects remain,
+	 * joining the pairs that waste the fewest pixels first. Returns false when a full upload is cheaper.
+	 */
+	static bool Coalesce(TArray<FIntRect>& InOutRects, FIntPoint BufferSize);
+
+	/**
+	 * Copies the dirty regions of a BGRA8 Buffer of Width x Height and uploads them to Texture on the render thread.
+	 * Falls back to a full upload when the texture is resized, not RHI backed, or mostly dirty.
+	 */
+	static void Upload(FSlateUpdatableTexture* Texture, uint32 Width, uint32 Height, const void* Buffer, TArray<FIntRect> DirtyRects);
+};
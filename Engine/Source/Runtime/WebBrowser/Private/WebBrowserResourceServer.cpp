@@ -0,0 +1,472 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WebBrowserResourceServer.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryWriter.h"
+#include "WebBrowserLog.h"
+#include "WebBrowserModule.h"
+#include "IWebBrowserSingleton.h"
+#include "IWebBrowserSchemeHandler.h"
+
+static int32 GWebBrowserResourceCacheSizeMB = 64;
+static FAutoConsoleVariableRef CVarWebBrowserResourceCacheSizeMB(
+	TEXT("r.WebBrowser.ResourceCache.SizeMB"),
+	GWebBrowserResourceCacheSizeMB,
+	TEXT("Budget of decompressed web UI files kept in memory by the browser resource server, least recently used files are dropped first."),
+	ECVF_Default
+	);
+
+static const uint32 ResourceArchiveMagic = 0x42574555; // UEWB
+static const uint32 ResourceArchiveVersion = 1;
+
+static FString GetResourceMimeType(const FString& Path)
+{
+	const FString Extension = FPaths::GetExtension(Path).ToLower();
+	if (Extension == TEXT("html") || Extension == TEXT("htm"))	return TEXT("text/html");
+	if (Extension == TEXT("js") || Extension == TEXT("mjs"))	return TEXT("text/javascript");
+	if (Extension == TEXT("css"))								return TEXT("text/css");
+	if (Extension == TEXT("json") || Extension == TEXT("map"))	return TEXT("application/json");
+	if (Extension == TEXT("svg"))								return TEXT("image/svg+xml");
+	if (Extension == TEXT("txt"))								return TEXT("text/plain");
+	if (Extension == TEXT("png"))								return TEXT("image/png");
+	if (Extension == TEXT("jpg") || Extension == TEXT("jpeg"))	return TEXT("image/jpeg");
+	if (Extension == TEXT("webp"))								return TEXT("image/webp");
+	if (Extension == TEXT("woff"))								return TEXT("font/woff");
+	if (Extension == TEXT("woff2"))								return TEXT("font/woff2");
+	if (Extension == TEXT("ttf"))								return TEXT("font/ttf");
+	if (Extension == TEXT("wasm"))								return TEXT("application/wasm");
+	return TEXT("application/octet-stream");
+}
+
+/** Decodes every %XX escape of a url path as UTF-8, malformed escapes are kept as they are. */
+static FString DecodeUrlPath(const FString& Path)
+{
+	const FTCHARToUTF8 Encoded(*Path);
+	TArray<ANSICHAR> Decoded;
+	Decoded.Reserve(Encoded.Length());
+	for (int32 Index = 0; Index < Encoded.Length(); ++Index)
+	{
+		const ANSICHAR Char = Encoded.Get()[Index];
+		if (Char == '%' && Index + 2 < Encoded.Length() && FChar::IsHexDigit(Encoded.Get()[Index + 1]) && FChar::IsHexDigit(Encoded.Get()[Index + 2]))
+		{
+			Decoded.Add((ANSICHAR)((FParse::HexDigit(Encoded.Get()[Index + 1]) << 4) | FParse::HexDigit(Encoded.Get()[Index + 2])));
+			Index += 2;
+		}
+		else
+		{
+			Decoded.Add(Char);
+		}
+	}
+
+	const FUTF8ToTCHAR Result(Decoded.GetData(), Decoded.Num());
+	return FString(Result.Length(), Result.Get());
+}
+
+/** Splits http(s)://Host/Path?Query into host and archive path, an empty path is index.html. */
+static bool SplitResourceUrl(const FString& Url, FString& OutHost, FString& OutPath)
+{
+	int32 SchemeEnd = Url.Find(TEXT("://"));
+	if (SchemeEnd == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FString Rest = Url.RightChop(SchemeEnd + 3);
+	int32 QueryStart = INDEX_NONE;
+	if (Rest.FindChar(TCHAR('?'), QueryStart) || Rest.FindChar(TCHAR('#'), QueryStart))
+	{
+		Rest.LeftInline(QueryStart);
+	}
+
+	if (!Rest.Split(TEXT("/"), &OutHost, &OutPath))
+	{
+		OutHost = Rest;
+		OutPath.Reset();
+	}
+
+	OutHost.ToLowerInline();
+	OutPath = DecodeUrlPath(OutPath);
+	if (OutPath.IsEmpty() || OutPath.EndsWith(TEXT("/")))
+	{
+		OutPath += TEXT("index.html");
+	}
+	return true;
+}
+
+/** Answers one request from a resource found in the archive. */
+class FWebBrowserResourceSchemeHandler : public IWebBrowserSchemeHandler
+{
+public:
+	explicit FWebBrowserResourceSchemeHandler(FWebBrowserResource&& InResource)
+		: Resource(MoveTemp(InResource))
+	{
+	}
+
+	virtual bool ProcessRequest(const FString& Verb, const FString& Url, const FSimpleDelegate& OnHeadersReady) override
+	{
+		OnHeadersReady.Execute();
+		return true;
+	}
+
+	virtual void GetResponseHeaders(IHeaders& OutHeaders) override
+	{
+		OutHeaders.SetMimeType(*Resource.MimeType);
+		OutHeaders.SetStatusCode(200);
+		OutHeaders.SetContentLength(Resource.Data->Num());
+		OutHeaders.SetHeader(TEXT("ETag"), *Resource.ETag);
+		OutHeaders.SetHeader(TEXT("Cache-Control"), *Resource.CacheControl);
+	}
+
+	virtual bool ReadResponse(uint8* OutBytes, int32 BytesToRead, int32& BytesRead, const FSimpleDelegate& OnMoreDataReady) override
+	{
+		BytesRead = FMath::Min(BytesToRead, Resource.Data->Num() - ReadOffset);
+		if (BytesRead <= 0)
+		{
+			BytesRead = 0;
+			return false;
+		}
+
+		FMemory::Memcpy(OutBytes, Resource.Data->GetData() + ReadOffset, BytesRead);
+		ReadOffset += BytesRead;
+		return true;
+	}
+
+	virtual void Cancel() override
+	{
+	}
+
+private:
+	FWebBrowserResource Resource;
+	int32 ReadOffset = 0;
+};
+
+class FWebBrowserResourceServer::FSchemeHandlerFactory : public IWebBrowserSchemeHandlerFactory
+{
+public:
+	virtual TUniquePtr<IWebBrowserSchemeHandler> Create(FString Verb, FString Url) override
+	{
+		// 归档里没有的文件返回空，请求继续走网络
+		FWebBrowserResource Resource;
+		if ((Verb != TEXT("GET") && Verb != TEXT("HEAD")) || !FWebBrowserResourceServer::Get().FindResource(Url, Resource))
+		{
+			return nullptr;
+		}
+		return MakeUnique<FWebBrowserResourceSchemeHandler>(MoveTemp(Resource));
+	}
+};
+
+static IWebBrowserSingleton* GetWebBrowserSingleton()
+{
+	return IWebBrowserModule::IsAvailable() && IWebBrowserModule::Get().IsWebModuleAvailable() ? IWebBrowserModule::Get().GetSingleton() : nullptr;
+}
+
+FWebBrowserResourceServer& FWebBrowserResourceServer::Get()
+{
+	static FWebBrowserResourceServer Server;
+	return Server;
+}
+
+FWebBrowserResourceServer::~FWebBrowserResourceServer()
+{
+	// 模块卸载后浏览器单例已销毁，工厂直接释放
+}
+
+bool FWebBrowserResourceServer::RegisterHost(const FString& Host, const FString& ArchivePath)
+{
+	TSharedPtr<FArchive> Archive = MakeShared<FArchive>();
+	Archive->File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*ArchivePath));
+	if (!Archive->File.IsValid())
+	{
+		UE_LOG(LogWebBrowser, Warning, TEXT("Could not map web resource archive %s"), *ArchivePath);
+		return false;
+	}
+
+	Archive->Region.Reset(Archive->File->MapRegion(0, Archive->File->GetFileSize()));
+	if (!Archive->Region.IsValid())
+	{
+		UE_LOG(LogWebBrowser, Warning, TEXT("Could not map web resource archive %s"), *ArchivePath);
+		return false;
+	}
+
+	// 目录在映射内存里直接解析，文件内容按需解压
+	const uint8* Data = Archive->Region->GetMappedPtr();
+	const int64 Size = Archive->Region->GetMappedSize();
+	int64 Offset = 0;
+	auto Read = [Data, Size, &Offset](void* Dest, int64 Bytes)
+	{
+		if (Offset + Bytes > Size)
+		{
+			return false;
+		}
+		FMemory::Memcpy(Dest, Data + Offset, Bytes);
+		Offset += Bytes;
+		return true;
+	};
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 NumEntries = 0;
+	bool bValid = Read(&Magic, sizeof(Magic)) && Read(&Version, sizeof(Version)) && Read(&NumEntries, sizeof(NumEntries))
+		&& Magic == ResourceArchiveMagic && Version == ResourceArchiveVersion;
+
+	for (uint32 Index = 0; bValid && Index < NumEntries; ++Index)
+	{
+		uint32 PathLength = 0;
+		FEntry Entry;
+		bValid = Read(&PathLength, sizeof(PathLength)) && Offset + PathLength <= Size;
+		if (bValid)
+		{
+			const FUTF8ToTCHAR Path(reinterpret_cast<const ANSICHAR*>(Data + Offset), PathLength);
+			Offset += PathLength;
+			bValid = Read(&Entry.Offset, sizeof(Entry.Offset)) && Read(&Entry.CompressedSize, sizeof(Entry.CompressedSize))
+				&& Read(&Entry.UncompressedSize, sizeof(Entry.UncompressedSize)) && Read(&Entry.Hash, sizeof(Entry.Hash))
+				&& Entry.Offset + Entry.CompressedSize <= (uint64)Size;
+			Archive->Entries.Add(FString(Path.Length(), Path.Get()), Entry);
+		}
+	}
+
+	if (!bValid)
+	{
+		UE_LOG(LogWebBrowser, Warning, TEXT("Web resource archive %s is corrupt or from another version"), *ArchivePath);
+		return false;
+	}
+
+	const FString HostKey = Host.ToLower();
+	if (!SchemeHandlerFactories.Contains(HostKey))
+	{
+		IWebBrowserSingleton* Singleton = GetWebBrowserSingleton();
+		TUniquePtr<FSchemeHandlerFactory> Factory = MakeUnique<FSchemeHandlerFactory>();
+		if (Singleton == nullptr || !Singleton->RegisterSchemeHandlerFactory(TEXT("https"), HostKey, Factory.Get()))
+		{
+			UE_LOG(LogWebBrowser, Warning, TEXT("Could not register a scheme handler for https://%s/"), *HostKey);
+			return false;
+		}
+		SchemeHandlerFactories.Add(HostKey, MoveTemp(Factory));
+	}
+
+	FScopeLock Lock(&CriticalSection);
+	Hosts.Add(HostKey, Archive);
+	for (auto It = Cache.CreateIterator(); It; ++It)
+	{
+		if (It.Key().StartsWith(HostKey + TEXT("/")))
+		{
+			CacheBytes -= It.Value().Data->Num();
+			It.RemoveCurrent();
+		}
+	}
+	bHasHosts = true;
+
+	UE_LOG(LogWebBrowser, Log, TEXT("Serving https://%s/ from %s (%d files)"), *HostKey, *ArchivePath, Archive->Entries.Num());
+	return true;
+}
+
+void FWebBrowserResourceServer::UnregisterHost(const FString& Host)
+{
+	const FString HostKey = Host.ToLower();
+	TUniquePtr<FSchemeHandlerFactory> Factory;
+	if (SchemeHandlerFactories.RemoveAndCopyValue(HostKey, Factory))
+	{
+		if (IWebBrowserSingleton* Singleton = GetWebBrowserSingleton())
+		{
+			Singleton->UnregisterSchemeHandlerFactory(Factory.Get());
+		}
+	}
+
+	FScopeLock Lock(&CriticalSection);
+	Hosts.Remove(HostKey);
+	for (auto It = Cache.CreateIterator(); It; ++It)
+	{
+		if (It.Key().StartsWith(HostKey + TEXT("/")))
+		{
+			CacheBytes -= It.Value().Data->Num();
+			It.RemoveCurrent();
+		}
+	}
+	bHasHosts = Hosts.Num() > 0;
+}
+
+bool FWebBrowserResourceServer::FindResource(const FString& Url, FWebBrowserResource& OutResource)
+{
+	if (!bHasHosts)
+	{
+		return false;
+	}
+
+	FString Host;
+	FString Path;
+	if (!SplitResourceUrl(Url, Host, Path))
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+	const TSharedPtr<FArchive>* Archive = Hosts.Find(Host);
+	if (Archive == nullptr)
+	{
+		return false;
+	}
+
+	const FEntry* Entry = (*Archive)->Entries.Find(Path);
+	if (Entry == nullptr)
+	{
+		return false;
+	}
+
+	const FString CacheKey = Host / Path;
+	FCachedResource* Cached = Cache.Find(CacheKey);
+	if (Cached == nullptr)
+	{
+		TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> Data = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+		Data->SetNumUninitialized(Entry->UncompressedSize);
+		const uint8* Source = (*Archive)->Region->GetMappedPtr() + Entry->Offset;
+		if (Entry->CompressedSize == Entry->UncompressedSize)
+		{
+			FMemory::Memcpy(Data->GetData(), Source, Entry->UncompressedSize);
+		}
+		else if (!FCompression::UncompressMemory(NAME_Zlib, Data->GetData(), Entry->UncompressedSize, Source, Entry->CompressedSize))
+		{
+			UE_LOG(LogWebBrowser, Warning, TEXT("Could not decompress %s from the web resource archive"), *Url);
+			return false;
+		}
+
+		Cached = &Cache.Add(CacheKey, FCachedResource{ Data, 0 });
+		CacheBytes += Data->Num();
+	}
+	Cached->LastUse = ++UseCounter;
+
+	OutResource.Data = Cached->Data;
+	OutResource.MimeType = GetResourceMimeType(Path);
+	OutResource.ETag = FString::Printf(TEXT("\"%08x\""), Entry->Hash);
+	// 归档换版本时重新注册，内容按ETag校验，不会用到旧缓存
+	OutResource.CacheControl = TEXT("public, max-age=31536000, immutable");
+
+	TrimCache();
+	return true;
+}
+
+void FWebBrowserResourceServer::TrimCache()
+{
+	const int64 Budget = int64(FMath::Max(GWebBrowserResourceCacheSizeMB, 0)) * 1024 * 1024;
+	while (CacheBytes > Budget && Cache.Num() > 1)
+	{
+		const FString* OldestKey = nullptr;
+		uint64 OldestUse = MAX_uint64;
+		for (const TPair<FString, FCachedResource>& Pair : Cache)
+		{
+			if (Pair.Value.LastUse < OldestUse)
+			{
+				OldestKey = &Pair.Key;
+				OldestUse = Pair.Value.LastUse;
+			}
+		}
+
+		// 正在返回的资源LastUse最大，不会被淘汰
+		const FString Key = *OldestKey;
+		CacheBytes -= Cache.FindChecked(Key).Data->Num();
+		Cache.Remove(Key);
+	}
+}
+
+bool FWebBrowserResourceServer::BuildArchive(const FString& SourceDir, const FString& ArchivePath)
+{
+	TArray<FString> Files;
+	IFileManager::Get().FindFilesRecursive(Files, *SourceDir, TEXT("*"), true, false);
+	Files.Sort();
+
+	FString Root = FPaths::ConvertRelativePathToFull(SourceDir);
+	FPaths::NormalizeDirectoryName(Root);
+	Root += TEXT("/");
+
+	TArray<uint8> Header;
+	TArray<uint8> Contents;
+	FMemoryWriter HeaderWriter(Header);
+	uint32 Magic = ResourceArchiveMagic;
+	uint32 Version = ResourceArchiveVersion;
+	uint32 NumEntries = Files.Num();
+	HeaderWriter << Magic << Version << NumEntries;
+
+	TArray<TArray<uint8>> CompressedFiles;
+	TArray<FEntry> Entries;
+	int64 HeaderSize = Header.Num();
+	for (const FString& File : Files)
+	{
+		TArray<uint8> Data;
+		if (!FFileHelper::LoadFileToArray(Data, *File))
+		{
+			UE_LOG(LogWebBrowser, Error, TEXT("Could not read %s"), *File);
+			return false;
+		}
+
+		FEntry& Entry = Entries.AddDefaulted_GetRef();
+		Entry.UncompressedSize = Data.Num();
+		Entry.Hash = FCrc::MemCrc32(Data.GetData(), Data.Num());
+
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Data.Num());
+		TArray<uint8>& Compressed = CompressedFiles.AddDefaulted_GetRef();
+		Compressed.SetNumUninitialized(CompressedSize);
+		if (FCompression::CompressMemory(NAME_Zlib, Compressed.GetData(), CompressedSize, Data.GetData(), Data.Num(), COMPRESS_BiasSize) && CompressedSize < Data.Num())
+		{
+			Compressed.SetNum(CompressedSize);
+		}
+		else
+		{
+			// 已经压缩过的图片字体直接存储
+			Compressed = MoveTemp(Data);
+		}
+		Entry.CompressedSize = Compressed.Num();
+
+		FString RelativePath = FPaths::ConvertRelativePathToFull(File);
+		RelativePath.RightChopInline(Root.Len());
+		HeaderSize += sizeof(uint32) + FTCHARToUTF8(*RelativePath).Length() + sizeof(uint64) + sizeof(uint32) * 3;
+	}
+
+	uint64 Offset = HeaderSize;
+	for (int32 Index = 0; Index < Files.Num(); ++Index)
+	{
+		FString RelativePath = FPaths::ConvertRelativePathToFull(Files[Index]);
+		RelativePath.RightChopInline(Root.Len());
+		const FTCHARToUTF8 PathUtf8(*RelativePath);
+		uint32 PathLength = PathUtf8.Length();
+		HeaderWriter << PathLength;
+		HeaderWriter.Serialize(const_cast<ANSICHAR*>(PathUtf8.Get()), PathLength);
+
+		FEntry& Entry = Entries[Index];
+		Entry.Offset = Offset;
+		HeaderWriter << Entry.Offset << Entry.CompressedSize << Entry.UncompressedSize << Entry.Hash;
+		Offset += Entry.CompressedSize;
+		Contents.Append(CompressedFiles[Index]);
+	}
+	check(Header.Num() == HeaderSize);
+
+	Header.Append(Contents);
+	if (!FFileHelper::SaveArrayToFile(Header, *ArchivePath))
+	{
+		UE_LOG(LogWebBrowser, Error, TEXT("Could not write %s"), *ArchivePath);
+		return false;
+	}
+
+	UE_LOG(LogWebBrowser, Display, TEXT("Wrote %d files from %s to %s (%lld bytes)"), Files.Num(), *SourceDir, *ArchivePath, (int64)Header.Num());
+	return true;
+}
+
+static FAutoConsoleCommand GWebBrowserBuildResourceArchiveCmd(
+	TEXT("WebBrowser.BuildResourceArchive"),
+	TEXT("WebBrowser.BuildResourceArchive <SourceDir> <Archive>: packs a web UI bundle into a compressed archive for FWebBrowserResourceServer::RegisterHost."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.Num() < 2)
+		{
+			UE_LOG(LogWebBrowser, Warning, TEXT("Usage: WebBrowser.BuildResourceArchive <SourceDir> <Archive>"));
+			return;
+		}
+		FWebBrowserResourceServer::BuildArchive(Args[0], Args[1]);
+	})
+	);
@@ -0,0 +1,193 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WebBrowserWindowPool.h"
+#include "IWebBrowserWindow.h"
+#include "IWebBrowserSingleton.h"
+#include "WebBrowserModule.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/CoreDelegates.h"
+
+static int32 GWebBrowserPoolSize = 0;
+static FAutoConsoleVariableRef CVarWebBrowserPoolSize(
+	TEXT("r.WebBrowser.Pool.Size"),
+	GWebBrowserPoolSize,
+	TEXT("Number of browser windows kept created on about:blank for views constructed with UseBrowserWindowPool. 0 disables pre-creation, released windows are closed."),
+	ECVF_Default
+	);
+
+static bool GWebBrowserPoolTransparent = false;
+static FAutoConsoleVariableRef CVarWebBrowserPoolTransparent(
+	TEXT("r.WebBrowser.Pool.Transparent"),
+	GWebBrowserPoolTransparent,
+	TEXT("Whether pre-created browser windows support transparency. Views asking for the other mode get a new window."),
+	ECVF_Default
+	);
+
+static int32 GWebBrowserPoolFrameRate = 24;
+static FAutoConsoleVariableRef CVarWebBrowserPoolFrameRate(
+	TEXT("r.WebBrowser.Pool.FrameRate"),
+	GWebBrowserPoolFrameRate,
+	TEXT("BrowserFrameRate of pre-created browser windows, capped by r.WebBrowser.MaxFrameRate like any view."),
+	ECVF_Default
+	);
+
+static const TCHAR* BlankUrl = TEXT("about:blank");
+
+FWebBrowserWindowPool& FWebBrowserWindowPool::Get()
+{
+	static FWebBrowserWindowPool Pool;
+	return Pool;
+}
+
+FWebBrowserWindowPool::FWebBrowserWindowPool()
+{
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FWebBrowserWindowPool::Tick), 0.1f);
+	FCoreDelegates::OnPreExit.AddRaw(this, &FWebBrowserWindowPool::Empty);
+}
+
+bool FWebBrowserWindowPool::CanUsePooledWindow(const FCreateBrowserWindowSettings& Settings)
+{
+	return Settings.bInterceptLoadRequests
+		&& !Settings.Context.IsSet();
+}
+
+FWebBrowserWindowPool::FConfiguration FWebBrowserWindowPool::GetConfiguration(const FCreateBrowserWindowSettings& Settings)
+{
+	FConfiguration Configuration;
+	Configuration.bUseTransparency = Settings.bUseTransparency;
+	Configuration.FrameRate = Settings.BrowserFrameRate;
+	Configuration.BackgroundColor = Settings.BackgroundColor;
+	return Configuration;
+}
+
+FCreateBrowserWindowSettings FWebBrowserWindowPool::GetPreCreateSettings()
+{
+	// 与SWebBrowserView一样受r.WebBrowser.MaxFrameRate限制，否则预创建的窗口永远匹配不上
+	static const TConsoleVariableData<int32>* CVarMaxFrameRate = IConsoleManager::Get().FindTConsoleVariableDataInt(TEXT("r.WebBrowser.MaxFrameRate"));
+	const int32 MaxFrameRate = CVarMaxFrameRate ? CVarMaxFrameRate->GetValueOnGameThread() : 0;
+
+	FCreateBrowserWindowSettings Settings;
+	Settings.InitialURL = BlankUrl;
+	Settings.bUseTransparency = GWebBrowserPoolTransparent;
+	Settings.BrowserFrameRate = MaxFrameRate > 0 ? FMath::Min(GWebBrowserPoolFrameRate, MaxFrameRate) : GWebBrowserPoolFrameRate;
+	return Settings;
+}
+
+int32 FWebBrowserWindowPool::GetNumAvailable() const
+{
+	int32 NumAvailable = 0;
+	for (const TPair<FConfiguration, TArray<TSharedPtr<IWebBrowserWindow>>>& Pair : Available)
+	{
+		NumAvailable += Pair.Value.Num();
+	}
+	return NumAvailable;
+}
+
+TSharedPtr<IWebBrowserWindow> FWebBrowserWindowPool::CreateWindow(const FCreateBrowserWindowSettings& Settings)
+{
+	static bool AllowCEF = !FParse::Param(FCommandLine::Get(), TEXT("nocef"));
+	bool bBrowserEnabled = true;
+	GConfig->GetBool(TEXT("Browser"), TEXT("bEnabled"), bBrowserEnabled, GEngineIni);
+	if (!AllowCEF || !bBrowserEnabled || !IWebBrowserModule::IsAvailable() || !IWebBrowserModule::Get().IsWebModuleAvailable())
+	{
+		return nullptr;
+	}
+	return IWebBrowserModule::Get().GetSingleton()->CreateBrowserWindow(Settings);
+}
+
+TSharedPtr<IWebBrowserWindow> FWebBrowserWindowPool::Acquire(const FCreateBrowserWindowSettings& Settings)
+{
+	if (!CanUsePooledWindow(Settings))
+	{
+		return CreateWindow(Settings);
+	}
+
+	const FConfiguration Configuration = GetConfiguration(Settings);
+	TArray<TSharedPtr<IWebBrowserWindow>>* Windows = Available.Find(Configuration);
+	if (Windows == nullptr || Windows->Num() == 0)
+	{
+		TSharedPtr<IWebBrowserWindow> Window = CreateWindow(Settings);
+		if (Window.IsValid())
+		{
+			AcquiredConfigurations.Add(Window.Get(), Configuration);
+		}
+		return Window;
+	}
+
+	TSharedPtr<IWebBrowserWindow> Window = Windows->Pop(false);
+	AcquiredConfigurations.Add(Window.Get(), Configuration);
+	Window->SetIsHidden(false);
+	if (Settings.ContentsToLoad.IsSet())
+	{
+		Window->LoadString(Settings.ContentsToLoad.GetValue(), Settings.InitialURL);
+	}
+	else
+	{
+		Window->LoadURL(Settings.InitialURL);
+	}
+	return Window;
+}
+
+void FWebBrowserWindowPool::Release(const TSharedPtr<IWebBrowserWindow>& Window)
+{
+	if (!Window.IsValid())
+	{
+		return;
+	}
+
+	// 不可复用设置创建的窗口没有记录配置，直接关闭
+	FConfiguration Configuration;
+	const bool bPoolable = AcquiredConfigurations.RemoveAndCopyValue(Window.Get(), Configuration);
+	TArray<TSharedPtr<IWebBrowserWindow>>& Windows = Available.FindOrAdd(Configuration);
+	if (!bPoolable || Windows.Num() >= GWebBrowserPoolSize || IsEngineExitRequested())
+	{
+		Window->CloseBrowser(true, false);
+		return;
+	}
+
+	// 回收前清空页面，脚本和媒体都停掉，隐藏后不再渲染
+	Window->StopLoad();
+	Window->LoadURL(BlankUrl);
+	Window->SetParentWindow(nullptr);
+	Window->SetIsHidden(true);
+	Windows.Add(Window);
+}
+
+void FWebBrowserWindowPool::Empty()
+{
+	for (const TPair<FConfiguration, TArray<TSharedPtr<IWebBrowserWindow>>>& Pair : Available)
+	{
+		for (const TSharedPtr<IWebBrowserWindow>& Window : Pair.Value)
+		{
+			Window->CloseBrowser(true, true);
+		}
+	}
+	Available.Empty();
+}
+
+bool FWebBrowserWindowPool::Tick(float DeltaTime)
+{
+	// Creating a browser stalls the game thread, so the pool is topped up one window per tick.
+	const FCreateBrowserWindowSettings PreCreateSettings = GetPreCreateSettings();
+	TArray<TSharedPtr<IWebBrowserWindow>>& PreCreated = Available.FindOrAdd(GetConfiguration(PreCreateSettings));
+	if (PreCreated.Num() < GWebBrowserPoolSize && !IsEngineExitRequested())
+	{
+		if (TSharedPtr<IWebBrowserWindow> Window = CreateWindow(PreCreateSettings))
+		{
+			Window->SetIsHidden(true);
+			PreCreated.Add(Window);
+		}
+	}
+
+	// 池子调小后每种配置各关掉一个多余的窗口
+	for (TPair<FConfiguration, TArray<TSharedPtr<IWebBrowserWindow>>>& Pair : Available)
+	{
+		if (Pair.Value.Num() > GWebBrowserPoolSize)
+		{
+			Pair.Value.Pop(false)->CloseBrowser(true, false);
+		}
+	}
+	return true;
+}
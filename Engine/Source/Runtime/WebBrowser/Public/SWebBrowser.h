@@ -39,6 +39,7 @@ public:
 		, _BrowserFrameRate(24)
 		, _PopupMenuMethod(TOptional<EPopupMethod>())
 		, _ViewportSize(FVector2D::ZeroVector)
+		, _UseBrowserWindowPool(false)
 	{ }
 
 		/** A reference to the parent window. */
@@ -80,6 +81,9 @@ public:
 		/** Desired size of the web browser viewport. */
 		SLATE_ATTRIBUTE(FVector2D, ViewportSize);
 
+		/** Take the browser window from FWebBrowserWindowPool and give it back on destruction, see SWebBrowserView. */
+		SLATE_ARGUMENT(bool, UseBrowserWindowPool)
+
 		/** Called when document loading completed. */
 		SLATE_EVENT(FSimpleDelegate, OnLoadCompleted)
 
@@ -240,6 +244,11 @@ public:
 	/** Set parent SWindow for this browser. */
 	WEBBROWSER_API void SetParentWindow(TSharedPtr<SWindow> Window);
 
+#pragma region Das
+	/** Marks the page as covered by opaque widgets so its off-screen rendering is suspended, see SWebBrowserView::SetIsOccluded. */
+	WEBBROWSER_API void SetIsOccluded(bool bOccluded);
+#pragma endregion
+
 private:
 
 	/** Navigate backwards. */
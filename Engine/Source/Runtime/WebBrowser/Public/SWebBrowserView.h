@@ -12,6 +12,8 @@
 #include "IWebBrowserSingleton.h"
 
 class FWebBrowserViewport;
+class FWebBrowserDataChannel;
+class FSlateUpdatableTexture;
 class IWebBrowserAdapter;
 class IWebBrowserDialog;
 class IWebBrowserPopupFeatures;
@@ -59,6 +61,7 @@ public:
 		, _ContextSettings()
 		, _AltRetryDomains(TArray<FString>())
 		, _ViewportSize(FVector2D::ZeroVector)
+		, _UseBrowserWindowPool(false)
 	{ }
 
 		/** A reference to the parent window. */
@@ -100,6 +103,9 @@ public:
 		/** Desired size of the web browser viewport. */
 		SLATE_ATTRIBUTE(FVector2D, ViewportSize);
 
+		/** Take the browser window from FWebBrowserWindowPool and give it back on destruction instead of creating and closing one. */
+		SLATE_ARGUMENT(bool, UseBrowserWindowPool)
+
 		/** Called when document loading completed. */
 		SLATE_EVENT(FSimpleDelegate, OnLoadCompleted)
 
@@ -176,6 +182,8 @@ public:
 
 	WEBBROWSER_API virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
 
+	WEBBROWSER_API virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override;
+
 	/**
 	 * Load the specified URL.
 	 *
@@ -289,6 +297,15 @@ public:
 
 #pragma region Das
 	WEBBROWSER_API TSharedPtr<IWebBrowserWindow> GetBrowserWindow();
+
+	/** Marks the view as covered by opaque widgets, which Slate cannot detect on its own. Off-screen rendering is suspended while set. */
+	WEBBROWSER_API void SetIsOccluded(bool bOccluded);
+
+	/** Whether the browser's off-screen rendering is suspended because the view is hidden, clipped out or occluded. */
+	bool IsRenderingSuspended() const { return bRenderingSuspended; }
+
+	/** Batched binary channel to the page. Null if the browser window is not valid or its load requests were already bound elsewhere. */
+	WEBBROWSER_API TSharedPtr<FWebBrowserDataChannel> GetDataChannel();
 #pragma endregion
 
 
@@ -302,6 +319,9 @@ private:
 	/** Callback to tell slate we want to update the contents of the web view based on changes inside the view. */
 	WEBBROWSER_API void HandleBrowserWindowNeedsRedraw();
 
+	/** Callback for browser paints, uploads only the dirty regions of the paint buffer to the window's texture. */
+	WEBBROWSER_API void HandleBrowserWindowPaint(FSlateUpdatableTexture* Texture, uint32 Width, uint32 Height, const void* Buffer, const TArray<FIntRect>& DirtyRects);
+
 	/** Callback for document title changes. */
 	WEBBROWSER_API void HandleTitleChanged(FString NewTitle);
 
@@ -369,6 +389,10 @@ private:
 	WEBBROWSER_API void HandleConsoleMessage(const FString& Message, const FString& Source, int32 Line, EWebBrowserConsoleLogSeverity Serverity);
 
 	WEBBROWSER_API TOptional<FSlateRenderTransform> GetPopupRenderTransform() const;
+
+	/** Suspends off-screen rendering once the view has not been painted on screen for r.WebBrowser.SuspendHiddenDelay. */
+	WEBBROWSER_API EActiveTimerReturnType UpdateRenderingSuspension(double InCurrentTime, float InDeltaTime);
+	WEBBROWSER_API void SetRenderingSuspended(bool bSuspended);
 private:
 
 	/** Interface for dealing with a web browser window. */
@@ -452,6 +476,27 @@ private:
 	/** A delegate that is invoked for each console message */
 	FOnConsoleMessageDelegate OnConsoleMessage;
 
+	/** Slate time the view was last painted inside its culling rect. */
+	mutable double LastVisiblePaintTime = 0.0;
+
+	/** Whether the browser window has been told it is hidden, which stops CEF painting and texture uploads. */
+	bool bRenderingSuspended = false;
+
+	/** Set by OnPaint when a suspended view was painted on screen, Tick resumes rendering. */
+	mutable bool bResumeRenderingRequested = false;
+
+	/** Set by the owner when opaque widgets cover the view. */
+	bool bIsOccluded = false;
+
+	/** Hidden-view check, unregistered while rendering is suspended. */
+	TSharedPtr<FActiveTimerHandle> SuspensionTimerHandle;
+
+	/** Bulk data channel to the page, see GetDataChannel. Only assigned in Construct, HandleLoadUrl reads it from the IO thread. */
+	TSharedPtr<FWebBrowserDataChannel> DataChannel;
+
+	/** Whether BrowserWindow came from FWebBrowserWindowPool and goes back there. */
+	bool bUsesPooledWindow = false;
+
 protected:
 	WEBBROWSER_API bool HandleSuppressContextMenu();
 
@@ -0,0 +1,76 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Containers/Queue.h"
+
+class IWebBrowserWindow;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnWebBrowserDataChannelMessage, const FString& /*Key*/, const TArray<uint8>& /*Payload*/);
+
+/**
+ * Keyed binary channel between C++ and a page, replacing one ExecuteJavascript per update with one batch per frame.
+ *
+ * Posting to a key that is still queued replaces its payload, so only the latest state of an object is sent. Once per frame
+ * the queued entries are packed into a single message and handed to the page, where listeners registered with
+ * window.ueChannel.onMessage(function(Key, ArrayBuffer) {...}) receive them. The page acknowledges every batch, and no new
+ * batch is sent while r.WebBrowser.DataChannel.MaxInFlight batches are unacknowledged, so a busy page slows the producer
+ * down instead of queueing scripts in CEF. The page side is installed once per document by OnDocumentReady, batches wait
+ * for it.
+ *
+ * The page sends back with window.ueChannel.send(Key, ArrayBuffer), broadcast by OnMessage on the game thread.
+ * Both directions are served through load request interception, so the browser must keep InterceptLoadRequests enabled.
+ */
+class FWebBrowserDataChannel
+	: public TSharedFromThis<FWebBrowserDataChannel>
+{
+public:
+	WEBBROWSER_API explicit FWebBrowserDataChannel(const TSharedRef<IWebBrowserWindow>& InBrowserWindow);
+	WEBBROWSER_API ~FWebBrowserDataChannel();
+
+	/** Queues Payload for Key, replacing a queued payload of the same key. Game thread. */
+	WEBBROWSER_API void Post(const FString& Key, TConstArrayView<uint8> Payload);
+
+	/** True while the page has not acknowledged enough batches to send another one. Producers may skip updates. */
+	WEBBROWSER_API bool IsBackPressured() const;
+
+	/** Number of keys waiting for the next batch. */
+	int32 GetNumPending() const { return PendingOrder.Num(); }
+
+	/** Drops queued entries and unacknowledged batches, used when the page navigates away. Sending waits for the next document. */
+	WEBBROWSER_API void Reset();
+
+	/** Installs window.ueChannel in the loaded document and starts sending. Call once per document. */
+	WEBBROWSER_API void OnDocumentReady();
+
+	/** Messages sent by the page. Game thread. */
+	FOnWebBrowserDataChannelMessage& OnMessage() { return MessageEvent; }
+
+	/** Serves the page's acknowledgements and messages. Returns false for urls that do not belong to the channel. */
+	WEBBROWSER_API bool HandleLoadUrl(const FString& Method, const FString& Url, FString& OutResponse);
+
+private:
+	bool Tick(float DeltaTime);
+	void SendBatch();
+
+	TWeakPtr<IWebBrowserWindow> BrowserWindow;
+
+	TMap<FString, TArray<uint8>> Pending;
+	TArray<FString> PendingOrder;
+
+	/** Send time of the batches the page has not acknowledged yet, by sequence number. */
+	TMap<uint32, double> InFlight;
+	uint32 NextSequence = 1;
+
+	/** Whether the current document has window.ueChannel. */
+	bool bDocumentReady = false;
+
+	/** Filled from whatever thread serves load requests, drained on the game thread. */
+	TQueue<uint32, EQueueMode::Mpsc> ReceivedAcks;
+	TQueue<TArray<uint8>, EQueueMode::Mpsc> ReceivedMessages;
+
+	FOnWebBrowserDataChannelMessage MessageEvent;
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/** A file served from a resource archive, with the headers a response for it should carry. */
+struct FWebBrowserResource
+{
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> Data;
+	FString MimeType;
+	FString ETag;
+	FString CacheControl;
+};
+
+/**
+ * Serves web UI bundles for virtual hosts from memory mapped archives, shared by all browser views.
+ *
+ * An archive is built once with WebBrowser.BuildResourceArchive <SourceDir> <Archive> and holds every file of the directory
+ * compressed. RegisterHost maps it, so opening a panel reads the table of contents from memory instead of touching the disk
+ * per file; decompressed files are kept in an LRU cache of r.WebBrowser.ResourceCache.SizeMB.
+ *
+ * Every registered host gets a scheme handler factory in the browser singleton, which answers https requests to it with the
+ * file, its MIME type, ETag and Cache-Control, so scripts, styles, images and fonts load like from a web server. Files the
+ * archive does not hold fall through to the network. RegisterHost and UnregisterHost run on the game thread, FindResource
+ * is thread safe.
+ */
+class FWebBrowserResourceServer
+{
+public:
+	static WEBBROWSER_API FWebBrowserResourceServer& Get();
+
+	WEBBROWSER_API ~FWebBrowserResourceServer();
+
+	/** Serves https://<Host>/<path> from the archive. Returns false if the archive cannot be mapped or read. */
+	WEBBROWSER_API bool RegisterHost(const FString& Host, const FString& ArchivePath);
+	WEBBROWSER_API void UnregisterHost(const FString& Host);
+
+	/** Looks up a url on a registered host. */
+	WEBBROWSER_API bool FindResource(const FString& Url, FWebBrowserResource& OutResource);
+
+	bool HasHosts() const { return bHasHosts; }
+
+	/** Writes every file below SourceDir into a compressed archive. */
+	static WEBBROWSER_API bool BuildArchive(const FString& SourceDir, const FString& ArchivePath);
+
+private:
+	class FSchemeHandlerFactory;
+
+	struct FEntry
+	{
+		uint64 Offset = 0;
+		uint32 CompressedSize = 0;
+		uint32 UncompressedSize = 0;
+		uint32 Hash = 0;
+	};
+
+	struct FArchive
+	{
+		TUniquePtr<IMappedFileHandle> File;
+		TUniquePtr<IMappedFileRegion> Region;
+		TMap<FString, FEntry> Entries;
+	};
+
+	struct FCachedResource
+	{
+		TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> Data;
+		uint64 LastUse = 0;
+	};
+
+	void TrimCache();
+
+	FCriticalSection CriticalSection;
+	TMap<FString, TSharedPtr<FArchive>> Hosts;
+	TMap<FString, FCachedResource> Cache;
+	int64 CacheBytes = 0;
+	uint64 UseCounter = 0;
+	std::atomic<bool> bHasHosts { false };
+
+	// 每个主机一个工厂，注销时按工厂注销；仅游戏线程
+	TMap<FString, TUniquePtr<FSchemeHandlerFactory>> SchemeHandlerFactories;
+};
@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+class IWebBrowserWindow;
+struct FCreateBrowserWindowSettings;
+
+/**
+ * Keeps r.WebBrowser.Pool.Size browser windows created ahead of time on about:blank, so opening a panel does not pay for
+ * browser creation. SWebBrowserView takes a window from here when constructed with UseBrowserWindowPool and hands it back
+ * when destroyed; a window given back is reset to about:blank, hidden and reused. Pre-creation starts with the first call to Get,
+ * so applications that want the first panel to open instantly should call it during startup.
+ *
+ * Windows are pooled per configuration of the settings that cannot change after creation: transparency, frame rate and
+ * background colour. Views that need a per-window context or no load interception always get a new window. Only the
+ * configuration of r.WebBrowser.Pool.* is pre-created, other configurations are filled by released windows, each up to
+ * r.WebBrowser.Pool.Size. Permanent UObject bindings survive a release, owners should unbind them first.
+ */
+class FWebBrowserWindowPool
+{
+public:
+	static WEBBROWSER_API FWebBrowserWindowPool& Get();
+
+	/** Returns a pooled window navigated to the settings' url or contents, or a newly created one. Null if browsers are unavailable. */
+	WEBBROWSER_API TSharedPtr<IWebBrowserWindow> Acquire(const FCreateBrowserWindowSettings& Settings);
+
+	/** Gives a window back for reuse, or closes it when the pool is full. */
+	WEBBROWSER_API void Release(const TSharedPtr<IWebBrowserWindow>& Window);
+
+	/** Closes every pooled window, called before the browser module shuts down. */
+	WEBBROWSER_API void Empty();
+
+	WEBBROWSER_API int32 GetNumAvailable() const;
+
+private:
+	FWebBrowserWindowPool();
+
+	/** The creation settings a pooled window has to match. */
+	struct FConfiguration
+	{
+		bool bUseTransparency = false;
+		int32 FrameRate = 0;
+		FColor BackgroundColor = FColor::White;
+
+		bool operator==(const FConfiguration& Other) const
+		{
+			return bUseTransparency == Other.bUseTransparency && FrameRate == Other.FrameRate && BackgroundColor == Other.BackgroundColor;
+		}
+
+		friend uint32 GetTypeHash(const FConfiguration& Configuration)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Configuration.bUseTransparency), GetTypeHash(Configuration.FrameRate)), GetTypeHash(Configuration.BackgroundColor));
+		}
+	};
+
+	bool Tick(float DeltaTime);
+	static bool CanUsePooledWindow(const FCreateBrowserWindowSettings& Settings);
+	static FConfiguration GetConfiguration(const FCreateBrowserWindowSettings& Settings);
+	static FCreateBrowserWindowSettings GetPreCreateSettings();
+	static TSharedPtr<IWebBrowserWindow> CreateWindow(const FCreateBrowserWindowSettings& Settings);
+
+	TMap<FConfiguration, TArray<TSharedPtr<IWebBrowserWindow>>> Available;
+
+	/** Configuration of every window handed out by Acquire that may come back. */
+	TMap<const IWebBrowserWindow*, FConfiguration> AcquiredConfigurations;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};